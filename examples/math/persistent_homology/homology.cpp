@@ -93,5 +93,76 @@ int main() {
 	}
 	printf("\n");
 
+	// 5. calculate the persistent diagram by one filtered complex, with exact epsilon
+	epsilon_interval.clear();
+	feture_type.clear();
+
+	zq::utils::Timer filtered_timeer;
+	filtered_timeer.Start();
+	zq::FilteredComplex<zq::Vec3f> filtered_complex;
+	zq::VRFilteredComplexConstruct<zq::Vec3f>(
+		max_epsilon,
+		points.value,
+		simplex_dimension,
+		filtered_complex
+	);
+	zq::CalculatePersistentDataSparse<zq::Vec3f>(
+		max_epsilon,
+		filtered_complex,
+		epsilon_interval,
+		feture_type
+	);
+	filtered_timeer.Stop();
+	std::cout << " using filtered complex, time:" << filtered_timeer.Elapsed() << "ms" << std::endl;
+	for (int i = 0; i < epsilon_interval.size(); i++) {
+		printf("[%f,%f]\t", epsilon_interval[i].first, epsilon_interval[i].second);
+	}
+	printf("\n");
+
+	// 6. the same filtration stored as a simplex tree
+	epsilon_interval.clear();
+	feture_type.clear();
+
+	zq::utils::Timer tree_timeer;
+	tree_timeer.Start();
+	zq::SimplexTree<zq::Vec3f> simplex_tree;
+	zq::VRSimplexTreeConstruct<zq::Vec3f>(
+		max_epsilon,
+		points.value,
+		simplex_dimension,
+		simplex_tree
+	);
+	zq::CalculatePersistentDataSparse<zq::Vec3f>(
+		max_epsilon,
+		simplex_tree,
+		epsilon_interval,
+		feture_type
+	);
+	tree_timeer.Stop();
+	std::cout << " using simplex tree, time:" << tree_timeer.Elapsed() << "ms" << std::endl;
+	for (int i = 0; i < epsilon_interval.size(); i++) {
+		printf("[%f,%f]\t", epsilon_interval[i].first, epsilon_interval[i].second);
+	}
+	printf("\n");
+
+	// 7. only the H0 intervals, by union-find on the neighbor graph
+	epsilon_interval.clear();
+	feture_type.clear();
+
+	zq::utils::Timer h0_timeer;
+	h0_timeer.Start();
+	zq::CalculatePersistentDataH0<zq::Vec3f>(
+		max_epsilon,
+		points.value,
+		epsilon_interval,
+		feture_type
+	);
+	h0_timeer.Stop();
+	std::cout << " H0 by union-find, time:" << h0_timeer.Elapsed() << "ms" << std::endl;
+	for (int i = 0; i < epsilon_interval.size(); i++) {
+		printf("[%f,%f]\t", epsilon_interval[i].first, epsilon_interval[i].second);
+	}
+	printf("\n");
+
 	return 0;
 }
\ No newline at end of file
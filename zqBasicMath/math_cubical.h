@@ -0,0 +1,255 @@
+/***********************************************************/
+/**	\file
+	\brief		cubical complex
+	\details	persistent homology of scalar fields on regular grids, with
+				boundary columns generated on demand
+	\author		Zhiqi Li
+	\date	    10/17/2026
+
+*/
+/***********************************************************/
+#ifndef __MATH_CUBICAL_H__
+#define __MATH_CUBICAL_H__
+
+#include <assert.h>
+#include <iostream>
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+#include <zqBasicMath/math_vector.h>
+#include <zqBasicMath/math_homology.h>
+#include <zqBasicUtils/utils_array.h>
+namespace zq {
+
+	/**
+		Cubical complex of a d dimensional grid of vertex values, in the
+		lower-star (V-construction) filtration: a cell enters once all its
+		vertices have, so its value is the largest value of its vertices.
+
+		A cell is a point of the doubled grid of shape 2 * shape - 1, indexed
+		as Vec<int,d>::Grid; the coordinates that are odd are the directions
+		it extends in, so its dimension is their number and its faces are the
+		neighbors along those directions. One value per cell is kept, computed
+		by one max pass per axis. The twist reduction of PersistencePairs
+		generates the boundary columns from Boundary() when it reduces them,
+		so on top of the values it keeps the filtration order and its inverse
+		and the pivot columns changed by the reduction. The other reductions
+		build the whole BoundaryMatrixZ2.
+	*/
+	template<int d>
+	class CubicalComplex {
+	public:
+		Vec<int, d> shape;			/// vertices along each axis
+		Vec<int, d> cell_shape;		/// 2 * shape - 1
+		Vec<int, d> stride;			/// index step along each axis of the doubled grid
+		Array<float> value;			/// value of each cell
+
+		CubicalComplex() {}
+		CubicalComplex(const Vec<int, d>& vertex_shape, const Array<float>& vertex_value) {
+			Init(vertex_shape, vertex_value);
+		}
+
+		/**
+			vertex_value is in row major, as Vec<int,d>::Grid of vertex_shape
+		*/
+		void Init(const Vec<int, d>& vertex_shape, const Array<float>& vertex_value) {
+			long long cells = 1;
+			long long vertices = 1;
+			for (int i = 0; i < d; i++) {
+				if (vertex_shape[i] < 1) throw "the grid shape should be positive";
+				cells *= 2 * (long long)vertex_shape[i] - 1;
+				vertices *= vertex_shape[i];
+				if (cells > INT_MAX) throw "too many cells for int indices";
+			}
+			if ((long long)vertex_value.size() != vertices) {
+				throw "the vertex values do not match the grid shape";
+			}
+			shape = vertex_shape;
+			for (int i = 0; i < d; i++) cell_shape[i] = 2 * shape[i] - 1;
+			stride[d - 1] = 1;
+			for (int i = d - 2; i >= 0; i--) stride[i] = stride[i + 1] * cell_shape[i + 1];
+			int n = CellNumber();
+			value.assign(n, 0);
+			for (int v = 0; v < vertex_value.size(); v++) {
+				Vec<int, d> coord;
+				shape.Grid(v, coord);
+				int cell = 0;
+				for (int i = 0; i < d; i++) cell += 2 * coord[i] * stride[i];
+				value[cell] = vertex_value[v];
+			}
+			/// a cell odd along the axis takes the max of its two neighbors, axis by axis
+			for (int axis = 0; axis < d; axis++) {
+				int s = stride[axis];
+				int outer = n / (s * cell_shape[axis]);
+#pragma omp parallel for
+				for (int o = 0; o < outer; o++) {
+					int base = o * s * cell_shape[axis];
+					for (int k = 1; k < cell_shape[axis]; k += 2) {
+						float* cell = &value[base + k * s];
+						const float* prev = cell - s;
+						const float* next = cell + s;
+						for (int j = 0; j < s; j++) cell[j] = myMax(prev[j], next[j]);
+					}
+				}
+			}
+		}
+
+		int CellNumber() const {
+			return cell_shape.Mul();
+		}
+
+		/// coordinate of cell along axis in the doubled grid, the layout of Vec<int,d>::Grid
+		int CellCoord(int cell, int axis) const {
+			return cell / stride[axis] % cell_shape[axis];
+		}
+
+		int CellDim(int cell) const {
+			int dim = 0;
+			for (int i = 0; i < d; i++) dim += CellCoord(cell, i) & 1;
+			return dim;
+		}
+
+		/**
+			the 2 * CellDim(cell) facets of cell, returns their number
+		*/
+		int Boundary(int cell, int* faces) const {
+			int num = 0;
+			for (int i = 0; i < d; i++) {
+				if (!(CellCoord(cell, i) & 1)) continue;
+				faces[num++] = cell - stride[i];
+				faces[num++] = cell + stride[i];
+			}
+			return num;
+		}
+
+		/**
+			Boundary of cell as sorted positions in the filtration order
+		*/
+		int ColumnFaces(int cell, const Array<int>& position, int* faces) const {
+			int num = Boundary(cell, faces);
+			for (int k = 0; k < num; k++) faces[k] = position[faces[k]];
+			std::sort(faces, faces + num);
+			return num;
+		}
+
+		/**
+			Cells in filtration order (value > dim > index), the faces come
+			before their cofaces. The value bits, made monotone, and the index
+			are packed in one 64 bit key sorted in cache; the runs of equal
+			value are then sorted by dimension.
+		*/
+		void FiltrationOrder(Array<int>& order) const {
+			int n = CellNumber();
+			Array<unsigned long long> key(n);
+#pragma omp parallel for
+			for (int i = 0; i < n; i++) {
+				unsigned int bits;
+				memcpy(&bits, &value[i], sizeof(float));
+				bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+				key[i] = ((unsigned long long)bits << 32) | (unsigned int)i;
+			}
+			std::sort(key.begin(), key.end());
+			order.resize(n);
+			for (int i = 0; i < n; i++) order[i] = (int)(key[i] & 0xffffffffu);
+			for (int i = 0; i < n;) {
+				int j = i + 1;
+				while (j < n && (key[j] >> 32) == (key[i] >> 32)) j++;
+				if (j - i > 1) {
+					std::stable_sort(order.begin() + i, order.begin() + j, [this](int a, int b) {
+						return CellDim(a) < CellDim(b);
+					});
+				}
+				i = j;
+			}
+		}
+
+		/**
+			Boundary matrix in filtration order, order[i] is the cell of column i
+		*/
+		template<class Column = Z2HeapColumn>
+		Z2BoundaryMatrix<Column> BoundaryMatrixZ2(Array<int>& order) const {
+			FiltrationOrder(order);
+			int n = order.size();
+			Array<int> position(n);
+			for (int i = 0; i < n; i++) position[order[i]] = i;
+			Z2BoundaryMatrix<Column> boundary_m(n);
+#pragma omp parallel for
+			for (int i = 0; i < n; i++) {
+				int faces[2 * d];
+				int num = ColumnFaces(order[i], position, faces);
+				boundary_m.cols[i].Set(faces, num);
+				boundary_m.dims[i] = CellDim(order[i]) + 1;	/// vertex count of a simplex of the same dimension
+			}
+			return boundary_m;
+		}
+
+		/**
+			Persistence pairs as positions in order, death is -1 for the
+			essential classes. morse_reduction as FilteredComplex::PersistencePairs,
+			which pays off on fields with flat regions. TWIST without it never
+			builds the boundary matrix, see ReduceZ2Implicit.
+		*/
+		void PersistencePairs(
+			Array<std::pair<int, int>>& interval,
+			Array<int>& order,
+			ReductionType type = ReductionType::TWIST,
+			bool morse_reduction = false
+		) const {
+			if (type == ReductionType::TWIST && !morse_reduction) {
+				FiltrationOrder(order);
+				int n = order.size();
+				Array<int> position(n);
+				for (int i = 0; i < n; i++) position[order[i]] = i;
+				ReduceZ2Implicit(
+					n,
+					[&](int i) { return CellDim(order[i]) + 1; },
+					[&](int i, Array<int>& entries) {
+						int faces[2 * d];
+						int num = ColumnFaces(order[i], position, faces);
+						entries.assign(faces, faces + num);
+					},
+					interval
+				);
+				return;
+			}
+			Z2BoundaryMatrix<> boundary_m = BoundaryMatrixZ2(order);
+			if (morse_reduction) {
+				Array<float> order_value(order.size());
+				for (int i = 0; i < order.size(); i++) order_value[i] = value[order[i]];
+				Simplical_Complex<int>::MorsePersistenceIntervals(boundary_m, order_value, interval, type);
+			}
+			else {
+				Simplical_Complex<int>::PersistenceIntervals(boundary_m, interval, type);
+			}
+		}
+	};
+
+	/**
+		Find the epsilon intervals of a cubical complex. feture_type is the
+		cell dimension + 1, as the vertex count of a simplex of the same
+		dimension, so the homology dimensions read as for the other complexes.
+	*/
+	template<int d>
+	void CalculatePersistentDataSparse(
+		float max_epsilon,
+		const CubicalComplex<d>& complex,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type,
+		ReductionType type = ReductionType::TWIST,
+		bool morse_reduction = false
+	) {
+		Array<std::pair<int, int>> interval;
+		Array<int> order;
+		complex.PersistencePairs(interval, order, type, morse_reduction);
+		for (int i = 0; i < interval.size(); i++) {
+			feture_type.push_back(complex.CellDim(order[interval[i].first]) + 1);
+			float start_epsilon = complex.value[order[interval[i].first]];
+			float end_epsilon = max_epsilon;
+			if (interval[i].second != -1) {
+				end_epsilon = complex.value[order[interval[i].second]];
+			}
+			epsilon_interval.push_back(std::pair<float, float>(start_epsilon, end_epsilon));
+		}
+	}
+}
+#endif
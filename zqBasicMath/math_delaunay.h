@@ -0,0 +1,351 @@
+/***********************************************************/
+/**	\file
+	\brief		delaunay triangulation
+	\details	circumsphere and Bowyer-Watson delaunay triangulation of
+				points in 1, 2 or 3 dimensions, used by the alpha complex
+	\author		Zhiqi Li, Yu Chen
+	\date	    10/17/2026
+
+*/
+/***********************************************************/
+#ifndef __MATH_DELAUNAY_H__
+#define __MATH_DELAUNAY_H__
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <float.h>
+#include <unordered_map>
+#include <algorithm>
+#include <zqBasicMath/math_utils.h>
+#include <zqBasicUtils/utils_array.h>
+namespace zq {
+
+	/**
+		Circumcenter of num points (num <= 4) in their affine hull. The points
+		are coords[index[i] * dim], dim <= 3. Return the squared radius, or
+		-1 if the points are affinely dependent.
+	*/
+	inline double Circumsphere(
+		const double* coords,
+		const int* index,
+		int num,
+		int dim,
+		double* center
+	) {
+		if (num < 1 || num > 4 || dim < 1 || dim > 3) throw "Circumsphere: at most 4 points in at most 3 dimensions";
+		const double* p0 = coords + index[0] * dim;
+		int m = num - 1;
+		double edge[3][3], gram[3][4];
+		for (int i = 0; i < m; i++) {
+			for (int k = 0; k < dim; k++) edge[i][k] = coords[index[i + 1] * dim + k] - p0[k];
+		}
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j < m; j++) {
+				gram[i][j] = 0;
+				for (int k = 0; k < dim; k++) gram[i][j] += edge[i][k] * edge[j][k];
+			}
+			gram[i][m] = 0.5 * gram[i][i];
+		}
+		/// gram * lambda = |edge|^2 / 2, by elimination with partial pivoting
+		for (int c = 0; c < m; c++) {
+			int pivot = c;
+			for (int r = c + 1; r < m; r++) {
+				if (fabs(gram[r][c]) > fabs(gram[pivot][c])) pivot = r;
+			}
+			if (gram[pivot][c] == 0) return -1;
+			for (int k = 0; k <= m; k++) std::swap(gram[c][k], gram[pivot][k]);
+			for (int r = c + 1; r < m; r++) {
+				double f = gram[r][c] / gram[c][c];
+				for (int k = c; k <= m; k++) gram[r][k] -= f * gram[c][k];
+			}
+		}
+		double lambda[3];
+		for (int c = m - 1; c >= 0; c--) {
+			lambda[c] = gram[c][m];
+			for (int k = c + 1; k < m; k++) lambda[c] -= gram[c][k] * lambda[k];
+			lambda[c] /= gram[c][c];
+		}
+		double radius2 = 0;
+		for (int k = 0; k < dim; k++) {
+			double offset = 0;
+			for (int i = 0; i < m; i++) offset += lambda[i] * edge[i][k];
+			center[k] = p0[k] + offset;
+			radius2 += offset * offset;
+		}
+		return radius2;
+	}
+
+	/**
+		Delaunay triangulation of the points coords[i * dim], dim is 1, 2 or 3
+		and the points should span R^dim. Bowyer-Watson insertion in Morton
+		order: the simplices whose circumsphere contains the new point form a
+		connected cavity, which is found by a search from a conflicting
+		simplex near the last inserted point and replaced by the star of the
+		point. The points are perturbed by up to 1e-6 of the bounding box so
+		that cospherical inputs (e.g. grids and spheres) are triangulated.
+		The triangulation is the one of the perturbed points, so the alpha
+		filtration built on it inherits this jitter: among cospherical
+		simplices it keeps the ones the perturbation picks.
+		results are the top simplices, each with dim + 1 sorted indices.
+	*/
+	inline void DelaunayTriangulation(
+		const Array<double>& coords,
+		int dim,
+		Array<Array<int>>& results
+	) {
+		if (dim < 1 || dim > 3) throw "DelaunayTriangulation: dim should be 1, 2 or 3";
+		int n = coords.size() / dim;
+		if (n <= dim) return;
+		if (dim == 1) {
+			Array<int> order(n);
+			for (int i = 0; i < n; i++) order[i] = i;
+			std::sort(order.begin(), order.end(), [&](int a, int b) {return coords[a] < coords[b]; });
+			for (int i = 0; i + 1 < n; i++) {
+				results.push_back(Array<int>{myMin(order[i], order[i + 1]), myMax(order[i], order[i + 1])});
+			}
+			return;
+		}
+		int vertex_num = dim + 1;
+		double lower[3], upper[3];
+		for (int k = 0; k < dim; k++) lower[k] = upper[k] = coords[k];
+		for (int i = 0; i < n; i++) {
+			for (int k = 0; k < dim; k++) {
+				lower[k] = myMin(lower[k], coords[i * dim + k]);
+				upper[k] = myMax(upper[k], coords[i * dim + k]);
+			}
+		}
+		double extent = 0;
+		for (int k = 0; k < dim; k++) extent = myMax(extent, upper[k] - lower[k]);
+		if (extent == 0) return;
+
+		/// perturbed points, followed by the vertices of a super simplex
+		Array<double> pts((n + vertex_num) * dim);
+		uint64_t state = 0x9E3779B97F4A7C15ULL;
+		for (int i = 0; i < n * dim; i++) {
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			double noise = (double)(state >> 11) / (double)(1ULL << 53) - 0.5;
+			pts[i] = coords[i] + extent * 1e-6 * noise;
+		}
+		const double super_2d[3][2] = { {0, 2}, {-1.7320508075688772, -1}, {1.7320508075688772, -1} };
+		const double super_3d[4][3] = { {1, 1, 1}, {1, -1, -1}, {-1, 1, -1}, {-1, -1, 1} };
+		for (int v = 0; v < vertex_num; v++) {
+			for (int k = 0; k < dim; k++) {
+				double dir = dim == 2 ? super_2d[v][k] : super_3d[v][k];
+				pts[(n + v) * dim + k] = 0.5 * (lower[k] + upper[k]) + 1e3 * extent * dir;
+			}
+		}
+
+		/// insertion order along a Morton curve, for locality
+		int bits = dim == 2 ? 16 : 10;
+		Array<uint64_t> code(n, 0);
+		for (int i = 0; i < n; i++) {
+			for (int k = 0; k < dim; k++) {
+				uint64_t q = (uint64_t)((coords[i * dim + k] - lower[k]) / extent * ((1 << bits) - 1));
+				for (int b = 0; b < bits; b++) code[i] |= ((q >> b) & 1ULL) << (b * dim + k);
+			}
+		}
+		Array<int> order(n);
+		for (int i = 0; i < n; i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](int a, int b) {return code[a] < code[b]; });
+
+		Array<int> simplex;		/// vertex_num vertices per simplex
+		Array<int> neighbor;	/// across the facet opposite each vertex, -1 outside
+		Array<double> center;
+		Array<double> radius2;
+		Array<int> alive;
+		auto add_simplex = [&](const int* vertices) -> int {
+			int id = alive.size();
+			simplex.insert(simplex.end(), vertices, vertices + vertex_num);
+			neighbor.insert(neighbor.end(), vertex_num, -1);
+			center.resize(center.size() + dim);
+			double r2 = Circumsphere(get_ptr(pts), vertices, vertex_num, dim, get_ptr(center) + id * dim);
+			/// a flat simplex conflicts with every point, so it is replaced
+			radius2.push_back(r2 < 0 ? DBL_MAX : r2);
+			alive.push_back(1);
+			return id;
+		};
+		auto in_conflict = [&](int t, int p) -> bool {
+			if (radius2[t] == DBL_MAX) return true;
+			double dist2 = 0;
+			for (int k = 0; k < dim; k++) {
+				double d = pts[p * dim + k] - center[t * dim + k];
+				dist2 += d * d;
+			}
+			return dist2 < radius2[t];
+		};
+		/// orientation of the facet (dim vertices) against point q
+		auto orient = [&](const int* facet, int q) -> double {
+			const double* a = get_ptr(pts) + facet[0] * dim;
+			double e[3][3];
+			for (int i = 1; i < dim; i++) {
+				for (int k = 0; k < dim; k++) e[i - 1][k] = pts[facet[i] * dim + k] - a[k];
+			}
+			for (int k = 0; k < dim; k++) e[dim - 1][k] = pts[q * dim + k] - a[k];
+			if (dim == 2) return e[0][0] * e[1][1] - e[0][1] * e[1][0];
+			return e[0][0] * (e[1][1] * e[2][2] - e[1][2] * e[2][1])
+				- e[0][1] * (e[1][0] * e[2][2] - e[1][2] * e[2][0])
+				+ e[0][2] * (e[1][0] * e[2][1] - e[1][1] * e[2][0]);
+		};
+		/// whether q is strictly on the side of facet k of t where t lies
+		auto inner_side = [&](int t, int k, int q) -> bool {
+			int facet[3];
+			for (int l = 0, m = 0; l < vertex_num; l++) {
+				if (l != k) facet[m++] = simplex[t * vertex_num + l];
+			}
+			return orient(facet, simplex[t * vertex_num + k]) * orient(facet, q) > 0;
+		};
+		/// whether facet k of t separates q from t strictly
+		auto separates = [&](int t, int k, int q) -> bool {
+			int facet[3];
+			for (int l = 0, m = 0; l < vertex_num; l++) {
+				if (l != k) facet[m++] = simplex[t * vertex_num + l];
+			}
+			return orient(facet, simplex[t * vertex_num + k]) * orient(facet, q) < 0;
+		};
+		int super_vertices[4];
+		for (int v = 0; v < vertex_num; v++) super_vertices[v] = n + v;
+		add_simplex(super_vertices);
+
+		Array<int> recent(1, 0), created, cavity, stack, mark;
+		std::unordered_map<uint64_t, std::pair<int, int>> ridge_map;
+		for (int step = 0; step < n; step++) {
+			int p = order[step];
+			/// locate the simplex containing p by walking from the last star
+			int seed = recent[0];
+			for (int guard = 0; guard < alive.size(); guard++) {
+				int next = -1;
+				for (int i = 0; i < vertex_num && next == -1; i++) {
+					int k = (i + guard) % vertex_num;
+					/// move only across a facet that separates p strictly
+					if (neighbor[seed * vertex_num + k] != -1 && separates(seed, k, p)) {
+						next = neighbor[seed * vertex_num + k];
+					}
+				}
+				if (next == -1) break;
+				seed = next;
+			}
+			if (!in_conflict(seed, p)) {
+				/// the walk can stop short of p on rounding, then scan all simplices
+				/// for one containing p, as the cavity is grown and repaired from it
+				seed = -1;
+				for (int t = 0; t < alive.size() && seed == -1; t++) {
+					if (!alive[t] || !in_conflict(t, p)) continue;
+					bool contains = true;
+					for (int k = 0; k < vertex_num && contains; k++) contains = !separates(t, k, p);
+					if (contains) seed = t;
+				}
+			}
+			if (seed == -1) {
+				/// a simplex containing p conflicts with it unless p is one of its vertices
+				bool duplicate = false;
+				for (int s = 0; s < step && !duplicate; s++) {
+					int q = order[s];
+					duplicate = true;
+					for (int k = 0; k < dim; k++) {
+						if (fabs(coords[p * dim + k] - coords[q * dim + k]) > extent * 1e-6) duplicate = false;
+					}
+				}
+				if (!duplicate) throw "DelaunayTriangulation: a point conflicts with no simplex";
+				continue;
+			}
+			mark.resize(alive.size(), -1);
+			stack.assign(1, seed);
+			mark[seed] = step;
+			while (!stack.empty()) {
+				int t = stack.back();
+				stack.pop_back();
+				for (int k = 0; k < vertex_num; k++) {
+					int nb = neighbor[t * vertex_num + k];
+					if (nb != -1 && mark[nb] != step && in_conflict(nb, p)) {
+						mark[nb] = step;
+						stack.push_back(nb);
+					}
+				}
+			}
+			/// rounding can make the cavity not star-shaped from p, then the
+			/// simplices with a boundary facet not facing p are given back
+			for (bool changed = true; changed;) {
+				changed = false;
+				cavity.clear();
+				stack.assign(1, seed);
+				mark[seed] = -step - 2;
+				while (!stack.empty()) {
+					int t = stack.back();
+					stack.pop_back();
+					cavity.push_back(t);
+					for (int k = 0; k < vertex_num; k++) {
+						int nb = neighbor[t * vertex_num + k];
+						if (nb != -1 && mark[nb] == step) {
+							mark[nb] = -step - 2;
+							stack.push_back(nb);
+						}
+					}
+				}
+				for (int c = 0; c < cavity.size(); c++) mark[cavity[c]] = step;
+				for (int c = 0; c < cavity.size(); c++) {
+					int t = cavity[c];
+					if (t == seed) continue;
+					for (int k = 0; k < vertex_num; k++) {
+						int nb = neighbor[t * vertex_num + k];
+						if (nb != -1 && mark[nb] == step) continue;
+						if (!inner_side(t, k, p)) {
+							mark[t] = -1;
+							changed = true;
+							break;
+						}
+					}
+				}
+			}
+			created.clear();
+			ridge_map.clear();
+			for (int c = 0; c < cavity.size(); c++) {
+				int t = cavity[c];
+				for (int k = 0; k < vertex_num; k++) {
+					int nb = neighbor[t * vertex_num + k];
+					if (nb != -1 && mark[nb] == step) continue;
+					/// the facet opposite k is on the cavity boundary, join it to p
+					int vertices[4];
+					for (int l = 0, m = 0; l < vertex_num; l++) {
+						if (l != k) vertices[m++] = simplex[t * vertex_num + l];
+					}
+					vertices[dim] = p;
+					int id = add_simplex(vertices);
+					created.push_back(id);
+					neighbor[id * vertex_num + dim] = nb;
+					if (nb != -1) {
+						for (int l = 0; l < vertex_num; l++) {
+							if (neighbor[nb * vertex_num + l] == t) neighbor[nb * vertex_num + l] = id;
+						}
+					}
+					/// the new simplices meet at the ridges of the facet, joined to p
+					for (int l = 0; l < dim; l++) {
+						int a = vertices[l == 0 ? 1 : 0];
+						int b = dim == 3 ? vertices[l == 2 ? 1 : 2] : a;
+						uint64_t key = (uint64_t)myMin(a, b) * (n + vertex_num) + myMax(a, b);
+						auto iter = ridge_map.find(key);
+						if (iter == ridge_map.end()) {
+							ridge_map[key] = std::pair<int, int>(id, l);
+						}
+						else {
+							neighbor[id * vertex_num + l] = iter->second.first;
+							neighbor[iter->second.first * vertex_num + iter->second.second] = id;
+						}
+					}
+				}
+			}
+			for (int c = 0; c < cavity.size(); c++) alive[cavity[c]] = 0;
+			recent.swap(created);
+		}
+
+		for (int t = 0; t < alive.size(); t++) {
+			if (!alive[t]) continue;
+			Array<int> vertices(simplex.begin() + t * vertex_num, simplex.begin() + (t + 1) * vertex_num);
+			if (*std::max_element(vertices.begin(), vertices.end()) >= n) continue;
+			std::sort(vertices.begin(), vertices.end());
+			results.push_back(vertices);
+		}
+	}
+}
+
+#endif	//	__MATH_DELAUNAY_H__
@@ -14,14 +14,19 @@
 #include <iostream>
 #include <math.h>
 #include<unordered_map>
+#include<unordered_set>
 #include<set>
 #include<algorithm>
 #include<functional>
+#include<tuple>
+#include<queue>
+#include<limits>
 #include <zqBasicMath/math_type_promote.h>
 #include <zqBasicMath/math_dense.h>
 #include <zqBasicMath/math_dense_solver.h>
 #include <zqBasicMath/math_sparse_matrix.h>
 #include <zqBasicMath/math_sparse_vector.h>
+#include <zqBasicMath/math_delaunay.h>
 #include <zqBasicUtils/utils_hash.h>
 #include <zqBasicUtils/utils_array.h>
 namespace zq {
@@ -54,9 +59,15 @@ namespace zq {
 			find the sub simplex of this simplex
 		*/
 		void FindSubSimplex(Array<Simplex<T>>& subsimplex) {
-			Array<bool> use(subsimplex.size());
-			while (AddIndex(use)) {
-				subsimplex.push_back(CreateSimplexByIndex(use));
+			int m = points.size();
+			if (m > 31) throw "the simplex has too many vertices for the bitmask enumeration";
+			Array<T> face;
+			for (unsigned mask = 1; mask < (1u << m); mask++) {
+				face.clear();
+				for (int i = 0; i < m; i++) {
+					if (mask >> i & 1) face.push_back(points[i]);
+				}
+				subsimplex.push_back(Simplex<T>(face));
 			}
 			SortSimplex(subsimplex);
 		}
@@ -92,31 +103,88 @@ namespace zq {
 			}
 			return points[i];
 		}
+	};
 
-	protected:
-		// following two functions are used to find all subsimplex 
-		bool AddIndex(Array<bool>& index) {
-			Array<bool> tem_index = index;
-			for (int i = 0; i < tem_index.size(); i++) {
-				if (tem_index[i] == false) {
-					tem_index[i] = true;
-					index = tem_index[i];
-					return true;
-				}
-				else {
-					tem_index[i] = false;
-				}
-			}
-			return false;
+	/**
+		Hash a sequence of vertex indices. Every vertex passes through a 64-bit
+		finalizer (splitmix64), so permutations and nearby index sets spread
+		over the whole range instead of cancelling as with plain XOR.
+	*/
+	inline size_t HashVertexSequence(const int* data, int num) {
+		uint64_t hv = 0x9E3779B97F4A7C15ULL * (uint64_t)(num + 1);
+		for (int i = 0; i < num; i++) {
+			hv ^= (uint64_t)(uint32_t)data[i];
+			hv += 0x9E3779B97F4A7C15ULL;
+			hv = (hv ^ (hv >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			hv = (hv ^ (hv >> 27)) * 0x94D049BB133111EBULL;
+			hv ^= hv >> 31;
+		}
+		return (size_t)hv;
+	}
+
+#ifndef ZQ_SIMPLEX_KEY_CAPACITY
+#define ZQ_SIMPLEX_KEY_CAPACITY 8
+#endif
+	/**
+		Compact key of an integer simplex. Up to ZQ_SIMPLEX_KEY_CAPACITY
+		vertices are stored inline, so hash sets and maps of simplices do not
+		allocate per entry, larger simplices are kept in spill. The vertex
+		order is kept as given, sort Data() first if the key should not
+		depend on it.
+	*/
+	class SimplexKey {
+	public:
+		int vertex[ZQ_SIMPLEX_KEY_CAPACITY];
+		Array<int> spill;	/// the vertices if there are more than ZQ_SIMPLEX_KEY_CAPACITY
+		int count = 0;
+		SimplexKey() {}
+		SimplexKey(const int* data, int dim_num) {
+			Assign(data, dim_num);
 		}
-		Simplex<T> CreateSimplexByIndex(Array<bool>& index) {
-			Array<T> new_points;
-			for (int i = 0; i < index.size(); i++) {
-				if (index[i]) {
-					new_points.push_back(points[i]);
-				}
+		SimplexKey(const Array<int>& data) {
+			Assign(data.size() ? &data[0] : nullptr, data.size());
+		}
+		SimplexKey(const Simplex<int>& simplex) {
+			Assign(simplex.points.size() ? &simplex.points[0] : nullptr, simplex.points.size());
+		}
+	public:
+		void Assign(const int* data, int dim_num) {
+			Resize(dim_num);
+			int* target = Data();
+			for (int i = 0; i < dim_num; i++) target[i] = data[i];
+		}
+		/// set the number of vertices, the vertices are then written through Data()
+		void Resize(int dim_num) {
+			count = dim_num;
+			if (dim_num > ZQ_SIMPLEX_KEY_CAPACITY) spill.resize(dim_num);
+			else spill.clear();
+		}
+		int* Data() {
+			return count > ZQ_SIMPLEX_KEY_CAPACITY ? get_ptr(spill) : vertex;
+		}
+		const int* Data() const {
+			return count > ZQ_SIMPLEX_KEY_CAPACITY ? get_ptr(spill) : vertex;
+		}
+		int Dim() const {
+			return count;
+		}
+		int index(int i) const {
+			return Data()[i];
+		}
+		Simplex<int> ToSimplex() const {
+			return Simplex<int>(Data(), count);
+		}
+		size_t Hash() const {
+			return HashVertexSequence(Data(), count);
+		}
+		bool operator== (const SimplexKey& rhs) const {
+			if (count != rhs.count) return false;
+			const int* data = Data();
+			const int* rhs_data = rhs.Data();
+			for (int i = 0; i < count; i++) {
+				if (data[i] != rhs_data[i]) return false;
 			}
-			return Simplex<T>(&new_points[0], new_points.size());
+			return true;
 		}
 	};
 }
@@ -127,11 +195,16 @@ namespace std {
 	public:
 		size_t operator()(const zq::Simplex<int>& p) const
 		{
-			size_t hv = 0;
-			for (int i = 0; i < p.Dim(); i++) {
-				hv ^= hash<int>()(p.index(i));
-			}
-			return hv;
+			return zq::HashVertexSequence(p.points.size() ? &p.points[0] : nullptr, p.points.size());
+		}
+
+	};
+	template<>
+	struct hash<zq::SimplexKey> {
+	public:
+		size_t operator()(const zq::SimplexKey& p) const
+		{
+			return p.Hash();
 		}
 
 	};
@@ -151,6 +224,564 @@ namespace std {
 }
 
 namespace zq{
+	/**
+		Column of a Z2 boundary matrix, stored as a sorted list of row indices.
+		Adding another column is a symmetric difference merged into a scratch
+		buffer, which is then swapped in, so no memory is allocated once the
+		buffer has grown.
+	*/
+	class Z2ListColumn {
+	public:
+		Array<int> entries;
+	public:
+		void Set(const int* data, int num) {
+			entries.assign(data, data + num);
+		}
+		void Get(Array<int>& result) const {
+			result = entries;
+		}
+		int Low() const {
+			if (entries.size() == 0) return -1;
+			return entries.back();
+		}
+		bool IsEmpty() const {
+			return entries.size() == 0;
+		}
+		int Size() const {
+			return entries.size();
+		}
+		void Clear() {
+			entries.clear();
+		}
+		void Add(const Z2ListColumn& col) {
+			static thread_local Array<int> buffer;
+			buffer.clear();
+			buffer.reserve(entries.size() + col.entries.size());
+			int i = 0, j = 0;
+			while (i < entries.size() && j < col.entries.size()) {
+				if (entries[i] < col.entries[j]) buffer.push_back(entries[i++]);
+				else if (entries[i] > col.entries[j]) buffer.push_back(col.entries[j++]);
+				else {
+					i++;
+					j++;
+				}
+			}
+			for (; i < entries.size(); i++) buffer.push_back(entries[i]);
+			for (; j < col.entries.size(); j++) buffer.push_back(col.entries[j]);
+			entries.swap(buffer);
+		}
+		void Prune() {}
+	};
+
+	/**
+		Column of a Z2 boundary matrix, stored as a max-heap of row indices
+		(the "vector heap" of PHAT). Adding a column only pushes its entries,
+		equal pairs cancel lazily when the pivot is queried.
+	*/
+	class Z2HeapColumn {
+	public:
+		mutable Array<int> entries;
+		int insert_count = 0;	/// pushes since the last prune
+	public:
+		void Set(const int* data, int num) {
+			entries.assign(data, data + num);
+			std::make_heap(entries.begin(), entries.end());
+			insert_count = 0;
+		}
+		void Get(Array<int>& result) const {
+			result = entries;
+			SortAndCancel(result);
+		}
+		int Low() const {
+			while (entries.size() != 0) {
+				int top = entries.front();
+				std::pop_heap(entries.begin(), entries.end());
+				entries.pop_back();
+				if (entries.size() != 0 && entries.front() == top) {
+					std::pop_heap(entries.begin(), entries.end());
+					entries.pop_back();
+				}
+				else {
+					entries.push_back(top);
+					std::push_heap(entries.begin(), entries.end());
+					return top;
+				}
+			}
+			return -1;
+		}
+		bool IsEmpty() const {
+			return Low() == -1;
+		}
+		int Size() const {
+			Array<int> tem;
+			Get(tem);
+			return tem.size();
+		}
+		void Clear() {
+			entries.clear();
+			insert_count = 0;
+		}
+		void Add(const Z2HeapColumn& col) {
+			for (int i = 0; i < col.entries.size(); i++) {
+				entries.push_back(col.entries[i]);
+				std::push_heap(entries.begin(), entries.end());
+			}
+			insert_count += col.entries.size();
+			if (insert_count > entries.size() / 2 + 16) Prune();
+		}
+		/**
+			drop the cancelled pairs, so the heap only holds the live entries
+		*/
+		void Prune() {
+			SortAndCancel(entries);
+			std::make_heap(entries.begin(), entries.end());
+			insert_count = 0;
+		}
+	protected:
+		static void SortAndCancel(Array<int>& data) {
+			std::sort(data.begin(), data.end());
+			int num = 0;
+			for (int i = 0; i < data.size(); i++) {
+				if (i + 1 < data.size() && data[i] == data[i + 1]) i++;
+				else data[num++] = data[i];
+			}
+			data.resize(num);
+		}
+	};
+
+	/**
+		Boundary matrix over Z2 stored by columns, which is the input of the
+		persistence reducers. Column i is the boundary of the i-th simplex of
+		the filtration, dims[i] is the number of vertices of that simplex.
+	*/
+	template<class Column = Z2HeapColumn>
+	class Z2BoundaryMatrix {
+	public:
+		Array<Column> cols;
+		Array<int> dims;
+		Array<Array<int>> added;	/// columns added to each column, empty unless TrackAdditions()
+	public:
+		Z2BoundaryMatrix(int n = 0) {
+			Resize(n);
+		}
+		void Resize(int n) {
+			cols.resize(n);
+			dims.resize(n, 0);
+		}
+		int Cols() const {
+			return cols.size();
+		}
+		int Low(int i) const {
+			return cols[i].Low();
+		}
+		bool IsEmpty(int i) const {
+			return cols[i].IsEmpty();
+		}
+		void AddColumn(int source, int target) {
+			cols[target].Add(cols[source]);
+			if (added.size() != 0) added[target].push_back(source);
+		}
+		/**
+			log the column additions of the following reduction, which is all
+			RepresentativeCycles needs instead of the full V matrix
+		*/
+		void TrackAdditions() {
+			added.assign(cols.size(), Array<int>());
+		}
+		void ClearColumn(int i) {
+			cols[i].Clear();
+		}
+		void FinalizeColumn(int i) {
+			cols[i].Prune();
+		}
+		/// entries should be sorted increasingly
+		void SetColumn(int i, const Array<int>& entries) {
+			cols[i].Set(get_ptr(entries), entries.size());
+		}
+		void GetColumn(int i, Array<int>& entries) const {
+			cols[i].Get(entries);
+		}
+		int NNZ() const {
+			int num = 0;
+			for (int i = 0; i < cols.size(); i++) num += cols[i].Size();
+			return num;
+		}
+		int MaxDim() const {
+			int max_dim = 0;
+			for (int i = 0; i < dims.size(); i++) max_dim = myMax(max_dim, dims[i]);
+			return max_dim;
+		}
+		/// every column has its dimension, as the twist and chunk reductions need
+		bool HasDims() const {
+			if (dims.size() != cols.size()) return false;
+			for (int i = 0; i < dims.size(); i++) {
+				if (dims[i] < 1) return false;
+			}
+			return true;
+		}
+		/**
+			Convert from the transposed SparseMatrixLIL, whose rows are the
+			columns of the boundary matrix. The boundary of a simplex has one
+			facet per vertex, so dims is read from the row sizes.
+		*/
+		static Z2BoundaryMatrix FromSparse(const SparseMatrixLIL<int>& boundary_m) {
+			Z2BoundaryMatrix result(boundary_m.row_num);
+			for (int i = 0; i < boundary_m.row_num; i++) {
+				result.SetColumn(i, boundary_m.rows[i]);
+				result.dims[i] = myMax((int)boundary_m.rows[i].size(), 1);
+			}
+			return result;
+		}
+	};
+
+	/**
+		Strategy used to reduce a boundary matrix
+			SCAN:		search all earlier columns for the same low, as the textbook loop
+			STANDARD:	look the low up in a low -> column pivot table
+			TWIST:		reduce dimensions from high to low, and clear the column
+						of the pivot row once it is paired (Chen and Kerber),
+						so that column is never reduced
+			COHOMOLOGY:	reduce the coboundary matrix instead, with clearing from
+						low to high dimension. Only the persistence routines
+						(PersistenceIntervals) dualize, ReduceZ2BoundaryMatrix
+						treats it as STANDARD
+			CHUNK:		split the columns into chunks, reduce each chunk locally in
+						parallel, then finish the remaining columns in one global
+						pass (Bauer, Kerber and Reininghaus), with clearing
+	*/
+	enum ReductionType {
+		SCAN,
+		STANDARD,
+		TWIST,
+		COHOMOLOGY,
+		CHUNK
+	};
+
+	/**
+		Chunk reduction. In the local phase a column of chunk c is only added
+		with columns of chunk c, and it is paired once its low falls into the
+		rows of chunk c, so every pivot entry and cleared column belongs to
+		one chunk and the chunks run in parallel. The columns whose low is
+		before their chunk are left to the global phase, where any pivot they
+		meet comes from an earlier chunk. boundary_m.dims should be set.
+	*/
+	template<class Column>
+	void _ReduceZ2BoundaryMatrixChunk(Z2BoundaryMatrix<Column>& boundary_m) {
+		if (!boundary_m.HasDims()) throw "the chunk reduction needs the dimension of every column";
+		int n = boundary_m.Cols();
+		int chunk_size = myMax((int)sqrt((double)n), 1);
+		int chunk_num = (n + chunk_size - 1) / chunk_size;
+		Array<int> pivot(n, -1);	/// low -> column
+		Array<int> finished(n, 0);	/// not Array<bool>, the chunks write it concurrently
+		for (int d = boundary_m.MaxDim(); d > 1; d--) {
+#pragma omp parallel for schedule(dynamic)
+			for (int c = 0; c < chunk_num; c++) {
+				int chunk_begin = c * chunk_size;
+				int chunk_end = myMin(chunk_begin + chunk_size, n);
+				for (int i = chunk_begin; i < chunk_end; i++) {
+					if (boundary_m.dims[i] != d) continue;
+					int low_i = boundary_m.Low(i);
+					while (low_i >= chunk_begin && pivot[low_i] != -1) {
+						boundary_m.AddColumn(pivot[low_i], i);
+						low_i = boundary_m.Low(i);
+					}
+					if (low_i == -1 || low_i >= chunk_begin) {
+						finished[i] = 1;
+						if (low_i != -1) {
+							pivot[low_i] = i;
+							finished[low_i] = 1;
+							boundary_m.ClearColumn(low_i);
+						}
+					}
+					boundary_m.FinalizeColumn(i);
+				}
+			}
+		}
+		for (int d = boundary_m.MaxDim(); d > 1; d--) {
+			for (int i = 0; i < n; i++) {
+				if (boundary_m.dims[i] != d || finished[i]) continue;
+				int low_i = boundary_m.Low(i);
+				while (low_i != -1 && pivot[low_i] != -1) {
+					boundary_m.AddColumn(pivot[low_i], i);
+					low_i = boundary_m.Low(i);
+				}
+				if (low_i != -1) {
+					pivot[low_i] = i;
+					boundary_m.ClearColumn(low_i);
+				}
+				boundary_m.FinalizeColumn(i);
+			}
+		}
+	}
+
+	/**
+		Standard persistence reduction over Z2: from left to right, add the
+		earlier column with the same low to the current column until its low
+		is unique. The columns are modified in place.
+		TWIST and CHUNK need boundary_m.dims, without them the matrix is
+		reduced as STANDARD.
+	*/
+	template<class Column>
+	void ReduceZ2BoundaryMatrix(
+		Z2BoundaryMatrix<Column>& boundary_m,
+		ReductionType type = ReductionType::STANDARD
+	) {
+		if ((type == ReductionType::TWIST || type == ReductionType::CHUNK) && !boundary_m.HasDims()) {
+			type = ReductionType::STANDARD;
+		}
+		if (type == ReductionType::CHUNK) {
+			_ReduceZ2BoundaryMatrixChunk(boundary_m);
+			return;
+		}
+		Array<int> lows(boundary_m.Cols(), -1);
+		Array<int> pivot(boundary_m.Cols(), -1);	/// low -> column
+		if (type == ReductionType::TWIST) {
+			for (int d = boundary_m.MaxDim(); d > 1; d--) {
+				for (int i = 0; i < boundary_m.Cols(); i++) {
+					if (boundary_m.dims[i] != d) continue;
+					int low_i = boundary_m.Low(i);
+					while (low_i != -1 && pivot[low_i] != -1) {
+						boundary_m.AddColumn(pivot[low_i], i);
+						low_i = boundary_m.Low(i);
+					}
+					if (low_i != -1) {
+						pivot[low_i] = i;
+						/// low_i is a positive simplex, its column reduces to zero
+						boundary_m.ClearColumn(low_i);
+					}
+					boundary_m.FinalizeColumn(i);
+				}
+			}
+			return;
+		}
+		for (int i = 0; i < boundary_m.Cols(); i++) {
+			int low_i = boundary_m.Low(i);
+			while (low_i != -1) {
+				int j = 0;
+				if (type == ReductionType::SCAN) {
+					for (; j < i; j++) {
+						if (lows[j] == low_i) break;
+					}
+					if (j == i) break;
+				}
+				else {
+					j = pivot[low_i];
+					if (j == -1) break;
+				}
+				boundary_m.AddColumn(j, i);
+				low_i = boundary_m.Low(i);
+			}
+			lows[i] = low_i;
+			if (low_i != -1) pivot[low_i] = i;
+			boundary_m.FinalizeColumn(i);
+		}
+	}
+
+	/**
+		Twist reduction of a boundary matrix that is never stored. column(i,
+		entries) writes the sorted boundary of column i, dim(i) its dimension
+		as in Z2BoundaryMatrix::dims. A column is generated when it is
+		reduced, and a pivot column is kept only if additions changed it, the
+		others are generated again when they are added. So the memory is two
+		arrays over the columns plus the changed pivots, which are few on
+		grids. interval is what ReadIntervals gives on the reduced matrix.
+	*/
+	template<class Column = Z2HeapColumn, class DimFunc, class ColumnFunc>
+	void ReduceZ2Implicit(
+		int n,
+		const DimFunc& dim,
+		const ColumnFunc& column,
+		Array<std::pair<int, int>>& interval
+	) {
+		int max_dim = 0;
+		for (int i = 0; i < n; i++) max_dim = myMax(max_dim, (int)dim(i));
+		Array<int> death(n, -1);	/// birth column -> the column that kills it, low -> pivot column
+		Array<char> negative(n, 0);
+		std::unordered_map<int, Column> changed;	/// pivot columns that differ from their boundary
+		Array<int> entries;
+		Column col, other;
+		for (int d = max_dim; d > 1; d--) {
+			for (int i = 0; i < n; i++) {
+				/// a paired birth column reduces to zero, so it is cleared
+				if (dim(i) != d || death[i] != -1) continue;
+				column(i, entries);
+				col.Set(get_ptr(entries), entries.size());
+				bool added = false;
+				int low_i = col.Low();
+				while (low_i != -1 && death[low_i] != -1) {
+					int j = death[low_i];
+					auto iter = changed.find(j);
+					if (iter != changed.end()) {
+						col.Add(iter->second);
+					}
+					else {
+						column(j, entries);
+						other.Set(get_ptr(entries), entries.size());
+						col.Add(other);
+					}
+					added = true;
+					low_i = col.Low();
+				}
+				if (low_i == -1) continue;
+				death[low_i] = i;
+				negative[i] = 1;
+				if (added) {
+					col.Prune();
+					changed.emplace(i, col);
+				}
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			if (!negative[i]) interval.push_back(std::pair<int, int>(i, death[i]));
+		}
+	}
+
+	/**
+		Rank over Z2 of the matrix whose columns are matrix.cols, by column
+		elimination with a pivot table. Columns are eliminated from the
+		sparsest to the densest to keep the fill-in small, and the columns
+		are modified in place.
+	*/
+	template<class Column>
+	int RankZ2(Z2BoundaryMatrix<Column>& matrix) {
+		int row_num = 0;
+		Array<int> order(matrix.Cols());
+		Array<int> nnz(matrix.Cols());
+		for (int i = 0; i < matrix.Cols(); i++) {
+			order[i] = i;
+			nnz[i] = matrix.cols[i].Size();
+			row_num = myMax(row_num, matrix.Low(i) + 1);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+			return nnz[a] < nnz[b];
+		});
+		Array<int> pivot(row_num, -1);
+		int rank = 0;
+		for (int k = 0; k < order.size(); k++) {
+			int i = order[k];
+			int low_i = matrix.Low(i);
+			while (low_i != -1 && pivot[low_i] != -1) {
+				matrix.AddColumn(pivot[low_i], i);
+				low_i = matrix.Low(i);
+			}
+			if (low_i != -1) {
+				pivot[low_i] = i;
+				matrix.FinalizeColumn(i);
+				rank++;
+			}
+		}
+		return rank;
+	}
+
+	/**
+		Rank over Z2 of a sparse matrix, the rank of the transpose is the same,
+		so each row of the LIL matrix is eliminated as a column
+	*/
+	inline int RankZ2(const SparseMatrixLIL<int>& matrix) {
+		Z2BoundaryMatrix<Z2ListColumn> columns = Z2BoundaryMatrix<Z2ListColumn>::FromSparse(matrix);
+		return RankZ2(columns);
+	}
+
+	inline int RankZ2(const SparseMatrixCSR<int>& matrix) {
+		Z2BoundaryMatrix<Z2ListColumn> columns(matrix.row_num);
+		Array<int> entries;
+		for (int i = 0; i < matrix.row_num; i++) {
+			entries.assign(matrix.col_id.begin() + matrix.row_start[i], matrix.col_id.begin() + matrix.row_start[i + 1]);
+			std::sort(entries.begin(), entries.end());
+			columns.SetColumn(i, entries);
+		}
+		return RankZ2(columns);
+	}
+
+	/**
+		Closure of a list of maximal simplices: faces[k] holds every face
+		with k + 1 vertices once, contiguously with k + 1 sorted vertices per
+		face, in lexicographic order. The faces of each simplex are
+		enumerated as the bitmasks with k + 1 bits set (Gosper's hack), then
+		bucketed by their first vertex and sorted and deduplicated bucket by
+		bucket in parallel.
+	*/
+	inline void SimplicialClosure(const Array<Array<int>>& maximal, Array<Array<int>>& faces) {
+		int n = maximal.size();
+		int max_size = 0, vertex_num = 0;
+		for (int i = 0; i < n; i++) {
+			max_size = myMax(max_size, (int)maximal[i].size());
+			for (int j = 0; j < maximal[i].size(); j++) vertex_num = myMax(vertex_num, maximal[i][j] + 1);
+		}
+		if (max_size > 31) throw "the simplex has too many vertices for the bitmask enumeration";
+		faces.assign(max_size, Array<int>());
+		for (int s = 1; s <= max_size; s++) {
+			/// offsets of the faces of each simplex, C(m, s) of them
+			Array<size_t> offset(n + 1, 0);
+			for (int i = 0; i < n; i++) {
+				int m = maximal[i].size();
+				size_t count = m < s ? 0 : 1;
+				for (int j = 0; j < s && m >= s; j++) count = count * (m - j) / (j + 1);
+				offset[i + 1] = offset[i] + count;
+			}
+			size_t face_num = offset[n];
+			Array<int> all(face_num * s);
+#pragma omp parallel for schedule(dynamic)
+			for (int i = 0; i < n; i++) {
+				int m = maximal[i].size();
+				if (m < s) continue;
+				int vertex[31];
+				for (int j = 0; j < m; j++) vertex[j] = maximal[i][j];
+				std::sort(vertex, vertex + m);
+				int* out = &all[0] + offset[i] * s;
+				for (unsigned mask = (1u << s) - 1; mask < (1u << m);) {
+					for (int j = 0; j < m; j++) {
+						if (mask >> j & 1) *out++ = vertex[j];
+					}
+					unsigned low = mask & (~mask + 1), ripple = mask + low;
+					mask = (((ripple ^ mask) >> 2) / low) | ripple;
+				}
+			}
+
+			/// bucket by the first vertex, then sort and unique each bucket
+			Array<size_t> bucket(vertex_num + 1, 0);
+			for (size_t f = 0; f < face_num; f++) bucket[all[f * s] + 1]++;
+			for (int v = 0; v < vertex_num; v++) bucket[v + 1] += bucket[v];
+			Array<int> bucketed(face_num * s);
+			Array<size_t> fill(bucket.begin(), bucket.end() - 1);
+			for (size_t f = 0; f < face_num; f++) {
+				size_t slot = fill[all[f * s]]++;
+				std::copy(&all[f * s], &all[f * s] + s, &bucketed[slot * s]);
+			}
+			Array<int>().swap(all);
+			Array<size_t> unique_num(vertex_num, 0);
+#pragma omp parallel for schedule(dynamic)
+			for (int v = 0; v < vertex_num; v++) {
+				size_t begin = bucket[v], num = bucket[v + 1] - begin;
+				if (num == 0) continue;
+				int* base = &bucketed[begin * s];
+				Array<int> order(num);
+				for (size_t f = 0; f < num; f++) order[f] = f;
+				std::sort(order.begin(), order.end(), [&](int a, int b) {
+					return std::lexicographical_compare(base + a * s, base + (a + 1) * s, base + b * s, base + (b + 1) * s);
+				});
+				Array<int> sorted;
+				sorted.reserve(num * s);
+				for (size_t f = 0; f < num; f++) {
+					const int* face = base + order[f] * s;
+					if (f > 0 && std::equal(face, face + s, sorted.end() - s)) continue;
+					sorted.insert(sorted.end(), face, face + s);
+				}
+				std::copy(sorted.begin(), sorted.end(), base);
+				unique_num[v] = sorted.size() / s;
+			}
+			Array<int>& result = faces[s - 1];
+			size_t total = 0;
+			for (int v = 0; v < vertex_num; v++) total += unique_num[v];
+			result.resize(total * s);
+			size_t pos = 0;
+			for (int v = 0; v < vertex_num; v++) {
+				std::copy(&bucketed[0] + bucket[v] * s, &bucketed[0] + (bucket[v] + unique_num[v]) * s, &result[0] + pos * s);
+				pos += unique_num[v];
+			}
+		}
+	}
+
 	/**
 		Simplical_Complex is orgamized by index
 		For the solver of Simplical_Complex, 2 types of boundary matrix are provided here:
@@ -209,20 +840,32 @@ namespace zq{
 			}
 		}
 
+		void AddSimplex(const Simplex<int>& simplex, std::unordered_set<SimplexKey>& simplex_set) {
+			if (simplex_set.insert(SimplexKey(simplex)).second) {
+				this->simplex.push_back(simplex);
+			}
+		}
+
+		void AddSimplex(const Array<int>& simplex_raw, std::unordered_set<SimplexKey>& simplex_set) {
+			if (simplex_set.insert(SimplexKey(simplex_raw)).second) {
+				this->simplex.push_back(Simplex<int>(&simplex_raw[0], simplex_raw.size()));
+			}
+		}
+
 		void AddComplex(const Simplex<int>& simplex) {
-			for (int i = 1; i <= simplex.size(); i++) {
-				Array<Array<int>> results;
-				auto filter = [](const Array<int>&)->bool {
-					return true;
-				};
-				FilterTuples(
-					simplex,
-					filter,
-					i,
-					results
-				);
-				for (int j = 0; j < results.size(); j++) {
-					AddSimplex(results[j]);
+			AddClosure(Array<Array<int>>(1, simplex.points));
+		}
+
+		/**
+			Add every face of the maximal simplices once, by dimension, see
+			SimplicialClosure
+		*/
+		void AddClosure(const Array<Array<int>>& maximal) {
+			Array<Array<int>> faces;
+			SimplicialClosure(maximal, faces);
+			for (int k = 0; k < faces.size(); k++) {
+				for (size_t f = 0; f < faces[k].size(); f += k + 1) {
+					simplex.push_back(Simplex<int>(&faces[k][f], k + 1));
 				}
 			}
 		}
@@ -285,8 +928,8 @@ namespace zq{
 					rank[j] = nullity[j] = 0;
 				}
 				else {
-					DenseMatrix<int> boundary_m =
-						BoundaryMatrix(
+					SparseMatrixLIL<int> boundary_m =
+						BoundaryMatrixSparse(
 							chains[j],
 							chains[j + 1]
 						);
@@ -361,19 +1004,38 @@ namespace zq{
 		}
 
 		DenseMatrix<int> ReducedBoundaryMatrix(
-			DenseMatrix<int>& memory_m
+			DenseMatrix<int>& memory_m,
+			ReductionType type = ReductionType::STANDARD
 		) {
 			DenseMatrix<int> boundary_m=BoundaryMatrix();
 			//std::cout << boundary_m << std::endl;
 			//printf("???? %d %d\n", Cols(boundary_m), Rows(boundary_m));
 			return ReduceBoundaryMatrix_Echelon(
 				boundary_m,
-				memory_m
+				memory_m,
+				type
 			);
 		}
 		
+		/**
+			Reduced boundary matrix without the V matrix, see the memory_m
+			versions for the cycles
+		*/
+		DenseMatrix<int> ReducedBoundaryMatrix(
+			ReductionType type = ReductionType::STANDARD
+		) {
+			return ReduceBoundaryMatrix_Echelon(BoundaryMatrix(), type);
+		}
+
+		SparseMatrixLIL<int> ReducedBoundaryMatrixSparse(
+			ReductionType type = ReductionType::STANDARD
+		) {
+			return ReduceBoundaryMatrix_Echelon(BoundaryMatrixSparse(), type);
+		}
+
 		SparseMatrixLIL<int> ReducedBoundaryMatrixSparse(
-			SparseMatrixLIL<int>& memory_m
+			SparseMatrixLIL<int>& memory_m,
+			ReductionType type = ReductionType::STANDARD
 		) {
 			SparseMatrixLIL<int> boundary_m = BoundaryMatrixSparse();
 			//std::cout << boundary_m << std::endl;
@@ -382,10 +1044,36 @@ namespace zq{
 			//printf("begin reduced\n");
 			return ReduceBoundaryMatrix_Echelon(
 				boundary_m,
-				memory_m
+				memory_m,
+				type
 			);
 		}
 
+		/**
+			Boundary matrix of the whole complex stored by Z2 columns, the
+			simplex order is the order of the array simplex
+		*/
+		template<class Column = Z2HeapColumn>
+		Z2BoundaryMatrix<Column> BoundaryMatrixZ2() {
+			Array<Array<int>> faces;
+			FacetIndex(simplex, simplex, faces);
+			Z2BoundaryMatrix<Column> boundary_m(simplex.size());
+			for (int i = 0; i < simplex.size(); i++) {
+				boundary_m.SetColumn(i, faces[i]);
+				boundary_m.dims[i] = simplex[i].Dim();
+			}
+			return boundary_m;
+		}
+
+		template<class Column = Z2HeapColumn>
+		Z2BoundaryMatrix<Column> ReducedBoundaryMatrixZ2(
+			ReductionType type = ReductionType::STANDARD
+		) {
+			Z2BoundaryMatrix<Column> boundary_m = BoundaryMatrixZ2<Column>();
+			ReduceZ2BoundaryMatrix(boundary_m, type);
+			return boundary_m;
+		}
+
 		static bool CheckReduced(const DenseMatrix<int>& boundary_m) {
 			std::set<int> low_set;
 			for (int i = 0; i < Cols(boundary_m); i++) {
@@ -424,12 +1112,13 @@ namespace zq{
 				complex_list[0].simplex[i].simplex_index = 0;
 			}
 			for (int i = 1; i < complex_list.size(); i++) {
-				std::unordered_map<Simplex<int>, int> simplex_map;
+				std::unordered_map<SimplexKey, int> simplex_map;
+				simplex_map.reserve(complex_list[i - 1].simplex.size());
 				for (int j = 0; j < complex_list[i-1].simplex.size(); j++) {
-					simplex_map.insert(std::pair<Simplex<int>, int>(complex_list[i - 1].simplex[j],j));
+					simplex_map.insert(std::pair<SimplexKey, int>(SimplexKey(complex_list[i - 1].simplex[j]), j));
 				}
 				for (int j = 0; j < complex_list[i].simplex.size(); j++) {
-					auto iter = simplex_map.find(complex_list[i].simplex[j]);
+					auto iter = simplex_map.find(SimplexKey(complex_list[i].simplex[j]));
 					if ( iter== simplex_map.end()) {
 						complex_list[i].simplex[j].simplex_index = i;
 					}
@@ -507,40 +1196,396 @@ namespace zq{
 			}
 		}
 		
-		static bool CheckUpperTriangleMatrix(const DenseMatrix<int>& boundary_m) {
-			for (int i = 0; i < Rows(boundary_m); i++) {
-				for (int j = 0; j < Cols(boundary_m); j++) {
-					if (boundary_m[i][j] == 1 && i >= j) {
-						return false;
-					}
-				}
-			}
-			return true;
-		}
-		
-		// This upper means the original standard boundary matrix is upper matrix
-		static bool CheckUpperTriangleMatrix(const SparseMatrixLIL<int>& boundary_m) {			
-			for (int i = 0; i < boundary_m.row_num; i++) {
-				for (int j = 0; j < boundary_m.rows[i].size(); j++) {
-					if (boundary_m.rows[i][j] >=i ) {
+		template<class Column>
+		static bool CheckReduced(const Z2BoundaryMatrix<Column>& boundary_m) {
+			std::set<int> low_set;
+			for (int i = 0; i < boundary_m.Cols(); i++) {
+				int low_i = boundary_m.Low(i);
+				if (low_i != -1) {
+					if (low_set.find(low_i) != low_set.end()) {
 						return false;
 					}
+					low_set.insert(low_i);
 				}
 			}
 			return true;
 		}
 
-		static DenseMatrix<int> ReduceBoundaryMatrix_Echelon(
-			const DenseMatrix<int>& boundary_m,
-			DenseMatrix<int>& memory_m
+		template<class Column>
+		static void ReadIntervals(
+			const Z2BoundaryMatrix<Column>& boundary_m,
+			Array<std::pair<int, int>>& interval
 		) {
-			DenseMatrix<int> result_boundary_m = boundary_m;
-			memory_m=IndentityMatrix<int>(Rows(result_boundary_m), Cols(result_boundary_m));
-			for (int i = 0; i < Cols(result_boundary_m); i++) {
-				bool end_loop = false;
-				while (!end_loop) {
-					end_loop = true;
-					for (int j = 0; j < i; j++) {
+			std::unordered_map<int, int> start_map;
+			for (int i = 0; i < boundary_m.Cols(); i++) {
+				int low_i = boundary_m.Low(i);
+				if (low_i == -1) {
+					interval.push_back(std::pair<int, int>(i, -1));
+					start_map.insert(std::pair<int, int>(i, interval.size() - 1));
+				}
+				else {
+					auto iter = start_map.find(low_i);
+					if (iter == start_map.end()) {
+						interval.push_back(std::pair<int, int>(low_i, i));
+						start_map.insert(std::pair<int, int>(low_i, interval.size() - 1));
+					}
+					else {
+						interval[iter->second].second = i;
+					}
+				}
+			}
+		}
+
+		/**
+			Persistent cohomology: reduce the anti-transpose of the boundary
+			matrix, whose column j is the coboundary of simplex N-1-j, with
+			the twist from low to high dimension. A pair (low, j) of the
+			coboundary matrix is the pair (N-1-j, N-1-low) of the boundary
+			matrix, so interval is the same as ReadIntervals would give.
+			For Rips filtrations most coboundary columns are cleared before
+			they are reached (de Silva, Morozov and Vejdemo-Johansson).
+			boundary_m.dims should be set.
+		*/
+		template<class Column>
+		static void CohomologyIntervals(
+			const Z2BoundaryMatrix<Column>& boundary_m,
+			Array<std::pair<int, int>>& interval
+		) {
+			if (!boundary_m.HasDims()) throw "the cohomology reduction needs the dimension of every column";
+			int n = boundary_m.Cols();
+			int max_dim = boundary_m.MaxDim();
+			Array<Array<int>> coboundary(n);
+			Array<int> entries;
+			for (int j = n - 1; j >= 0; j--) {
+				boundary_m.GetColumn(j, entries);
+				for (int k = 0; k < entries.size(); k++) {
+					coboundary[n - 1 - entries[k]].push_back(n - 1 - j);
+				}
+			}
+			Z2BoundaryMatrix<Column> coboundary_m(n);
+			for (int i = 0; i < n; i++) {
+				coboundary_m.SetColumn(i, coboundary[i]);
+				/// reversed, so the twist reduces the low dimensions first
+				coboundary_m.dims[i] = max_dim + 1 - boundary_m.dims[n - 1 - i];
+			}
+			Array<Array<int>>().swap(coboundary);
+			ReduceZ2BoundaryMatrix(coboundary_m, ReductionType::TWIST);
+			Array<int> death(n, -1);
+			Array<bool> negative(n, false);
+			for (int j = 0; j < n; j++) {
+				int low_j = coboundary_m.Low(j);
+				if (low_j == -1) continue;
+				death[n - 1 - j] = n - 1 - low_j;
+				negative[n - 1 - low_j] = true;
+			}
+			for (int i = 0; i < n; i++) {
+				if (!negative[i]) interval.push_back(std::pair<int, int>(i, death[i]));
+			}
+		}
+
+		/**
+			Persistence pairs of a boundary matrix as column indices, death is
+			-1 for the essential classes. boundary_m is reduced in place,
+			except for COHOMOLOGY, which reduces a coboundary copy. Without
+			boundary_m.dims, COHOMOLOGY reduces the boundary matrix as STANDARD.
+		*/
+		template<class Column>
+		static void PersistenceIntervals(
+			Z2BoundaryMatrix<Column>& boundary_m,
+			Array<std::pair<int, int>>& interval,
+			ReductionType type = ReductionType::TWIST
+		) {
+			if (type == ReductionType::COHOMOLOGY && boundary_m.HasDims()) {
+				CohomologyIntervals(boundary_m, interval);
+				return;
+			}
+			ReduceZ2BoundaryMatrix(boundary_m, type);
+			ReadIntervals(boundary_m, interval);
+		}
+
+		/**
+			Discrete Morse reduction of a filtered complex. A simplex is only
+			matched with a facet of the same value, so the matching is a
+			sequence of collapses inside each level of the filtration. The
+			levels are matched in turn by coreduction: a simplex with one
+			unmatched facet left is matched with it, otherwise the first
+			simplex left becomes critical. Cells are removed in that order,
+			so every gradient path goes to earlier removed cells and the
+			matching is acyclic.
+			morse_m is the boundary matrix of the critical simplices, its
+			column i is critical[i]. matching holds the (facet, coface) pairs.
+			Within a value, facets should come before their cofaces, as in
+			the orders of Sort() and FiltrationOrder().
+		*/
+		template<class Column>
+		static void MorseReduction(
+			const Z2BoundaryMatrix<Column>& boundary_m,
+			const Array<float>& value,
+			Z2BoundaryMatrix<Column>& morse_m,
+			Array<int>& critical,
+			Array<std::pair<int, int>>& matching
+		) {
+			int n = boundary_m.Cols();
+			Array<Array<int>> facets(n);
+			Array<int> coface_num(n + 1, 0);
+			for (int i = 0; i < n; i++) {
+				boundary_m.GetColumn(i, facets[i]);
+				for (int k = 0; k < facets[i].size(); k++) coface_num[facets[i][k] + 1]++;
+			}
+			for (int i = 0; i < n; i++) coface_num[i + 1] += coface_num[i];
+			Array<int> cofaces(coface_num[n]);
+			Array<int> offset(coface_num.begin(), coface_num.end() - 1);
+			for (int i = 0; i < n; i++) {
+				for (int k = 0; k < facets[i].size(); k++) cofaces[offset[facets[i][k]]++] = i;
+			}
+
+			/// partner of a matched cell, -1 for a critical cell
+			Array<int> partner(n, -1);
+			Array<int> removed_time(n, -1);
+			Array<int> left(n, 0);		/// facets not removed yet
+			Array<int> free_cells;
+			int time = 0;
+			auto remove = [&](int cell, int level_end) {
+				removed_time[cell] = time;
+				for (int k = coface_num[cell]; k < coface_num[cell + 1]; k++) {
+					int coface = cofaces[k];
+					if (coface >= level_end || removed_time[coface] != -1) continue;
+					if (--left[coface] == 1) free_cells.push_back(coface);
+				}
+			};
+			for (int level_begin = 0; level_begin < n;) {
+				int level_end = level_begin + 1;
+				while (level_end < n && value[level_end] == value[level_begin]) level_end++;
+				for (int i = level_begin; i < level_end; i++) {
+					for (int k = 0; k < facets[i].size(); k++) {
+						if (facets[i][k] >= level_begin) left[i]++;
+					}
+					if (left[i] == 1) free_cells.push_back(i);
+				}
+				for (int next = level_begin; next < level_end;) {
+					if (!free_cells.empty()) {
+						int coface = free_cells.back();
+						free_cells.pop_back();
+						if (removed_time[coface] != -1 || left[coface] != 1) continue;
+						int facet = -1;
+						for (int k = 0; k < facets[coface].size() && facet == -1; k++) {
+							if (removed_time[facets[coface][k]] == -1) facet = facets[coface][k];
+						}
+						partner[facet] = coface;
+						partner[coface] = facet;
+						matching.push_back(std::pair<int, int>(facet, coface));
+						remove(facet, level_end);
+						remove(coface, level_end);
+						time++;
+					}
+					else if (removed_time[next] != -1) {
+						next++;
+					}
+					else {
+						critical.push_back(next);
+						remove(next, level_end);
+						time++;
+					}
+				}
+				level_begin = level_end;
+			}
+
+			Array<int> critical_index(n, -1);
+			for (int i = 0; i < critical.size(); i++) critical_index[critical[i]] = i;
+			morse_m.Resize(critical.size());
+#pragma omp parallel for schedule(dynamic)
+			for (int i = 0; i < critical.size(); i++) {
+				/// follow the gradient paths from the facets, latest removed first
+				Array<std::pair<int, int>> heap;
+				Array<int> entries;
+				auto push = [&](int cell) {
+					heap.push_back(std::pair<int, int>(removed_time[cell], cell));
+					std::push_heap(heap.begin(), heap.end());
+				};
+				for (int k = 0; k < facets[critical[i]].size(); k++) push(facets[critical[i]][k]);
+				while (!heap.empty()) {
+					int cell = heap.front().second;
+					int count = 0;
+					while (!heap.empty() && heap.front().second == cell) {
+						std::pop_heap(heap.begin(), heap.end());
+						heap.pop_back();
+						count++;
+					}
+					if (count % 2 == 0) continue;
+					if (partner[cell] == -1) {
+						entries.push_back(critical_index[cell]);
+					}
+					else if (partner[cell] > cell) {
+						/// cell is the facet of its pair, replace it by the other facets of the coface
+						const Array<int>& coface_facets = facets[partner[cell]];
+						for (int k = 0; k < coface_facets.size(); k++) {
+							if (coface_facets[k] != cell) push(coface_facets[k]);
+						}
+					}
+				}
+				std::sort(entries.begin(), entries.end());
+				morse_m.SetColumn(i, entries);
+				morse_m.dims[i] = boundary_m.dims[critical[i]];
+			}
+		}
+
+		/**
+			Persistence pairs as PersistenceIntervals gives, computed on the
+			Morse complex of MorseReduction. The matched pairs have the same
+			value and are added as intervals of length zero. value is the
+			filtration value of each column of boundary_m.
+		*/
+		template<class Column>
+		static void MorsePersistenceIntervals(
+			const Z2BoundaryMatrix<Column>& boundary_m,
+			const Array<float>& value,
+			Array<std::pair<int, int>>& interval,
+			ReductionType type = ReductionType::TWIST
+		) {
+			Z2BoundaryMatrix<Column> morse_m;
+			Array<int> critical;
+			Array<std::pair<int, int>> matching;
+			MorseReduction(boundary_m, value, morse_m, critical, matching);
+			Array<std::pair<int, int>> morse_interval;
+			PersistenceIntervals(morse_m, morse_interval, type);
+			for (int i = 0; i < morse_interval.size(); i++) {
+				int death = morse_interval[i].second;
+				interval.push_back(std::pair<int, int>(critical[morse_interval[i].first], death == -1 ? -1 : critical[death]));
+			}
+			interval.insert(interval.end(), matching.begin(), matching.end());
+			std::sort(interval.begin(), interval.end());
+		}
+
+		/**
+			Representative cycle of each interval as column indices. A finite
+			interval (b, d) is represented by the reduced column d, a cycle
+			whose lowest simplex is b. An essential class b is represented by
+			column b of V, which is rebuilt from the logged additions only for
+			b and the columns added into it, so reduced_m should be reduced
+			after TrackAdditions().
+		*/
+		template<class Column>
+		static void RepresentativeCycles(
+			const Z2BoundaryMatrix<Column>& reduced_m,
+			const Array<std::pair<int, int>>& interval,
+			Array<Array<int>>& cycles
+		) {
+			cycles.resize(interval.size());
+			std::unordered_map<int, Array<int>> v_cols;
+			Array<int> stack, merged;
+			for (int i = 0; i < interval.size(); i++) {
+				if (interval[i].second != -1) {
+					reduced_m.GetColumn(interval[i].second, cycles[i]);
+					continue;
+				}
+				if (reduced_m.added.size() == 0) {
+					throw "the additions are not tracked";
+				}
+				stack.assign(1, interval[i].first);
+				while (!stack.empty()) {
+					int c = stack.back();
+					if (v_cols.find(c) != v_cols.end()) {
+						stack.pop_back();
+						continue;
+					}
+					const Array<int>& sources = reduced_m.added[c];
+					bool ready = true;
+					for (int k = 0; k < sources.size(); k++) {
+						if (v_cols.find(sources[k]) == v_cols.end()) {
+							stack.push_back(sources[k]);
+							ready = false;
+						}
+					}
+					if (!ready) continue;
+					/// V column c is e_c plus the V columns added into c
+					Array<int> chain(1, c);
+					for (int k = 0; k < sources.size(); k++) {
+						const Array<int>& source = v_cols[sources[k]];
+						merged.clear();
+						std::set_symmetric_difference(chain.begin(), chain.end(), source.begin(), source.end(), std::back_inserter(merged));
+						chain.swap(merged);
+					}
+					v_cols[c].swap(chain);
+					stack.pop_back();
+				}
+				cycles[i] = v_cols[interval[i].first];
+			}
+		}
+
+		static bool CheckUpperTriangleMatrix(const DenseMatrix<int>& boundary_m) {
+			for (int i = 0; i < Rows(boundary_m); i++) {
+				for (int j = 0; j < Cols(boundary_m); j++) {
+					if (boundary_m[i][j] == 1 && i >= j) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+		
+		// This upper means the original standard boundary matrix is upper matrix
+		static bool CheckUpperTriangleMatrix(const SparseMatrixLIL<int>& boundary_m) {			
+			for (int i = 0; i < boundary_m.row_num; i++) {
+				for (int j = 0; j < boundary_m.rows[i].size(); j++) {
+					if (boundary_m.rows[i][j] >=i ) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		/**
+			Reduce the boundary matrix, memory_m is the V matrix of R = DV.
+			It is n x n, so only ask for it when the cycles are needed.
+		*/
+		static DenseMatrix<int> ReduceBoundaryMatrix_Echelon(
+			const DenseMatrix<int>& boundary_m,
+			DenseMatrix<int>& memory_m,
+			ReductionType type = ReductionType::STANDARD
+		) {
+			return _ReduceBoundaryMatrix_Echelon(boundary_m, &memory_m, type);
+		}
+
+		static DenseMatrix<int> ReduceBoundaryMatrix_Echelon(
+			const DenseMatrix<int>& boundary_m,
+			ReductionType type = ReductionType::STANDARD
+		) {
+			return _ReduceBoundaryMatrix_Echelon(boundary_m, (DenseMatrix<int>*)nullptr, type);
+		}
+
+		static DenseMatrix<int> _ReduceBoundaryMatrix_Echelon(
+			const DenseMatrix<int>& boundary_m,
+			DenseMatrix<int>* memory_m,
+			ReductionType type
+		) {
+			DenseMatrix<int> result_boundary_m = boundary_m;
+			if (memory_m) *memory_m = IndentityMatrix<int>(Rows(result_boundary_m), Cols(result_boundary_m));
+			if (type == ReductionType::STANDARD) {
+				Array<int> pivot(Rows(result_boundary_m), -1);
+				for (int i = 0; i < Cols(result_boundary_m); i++) {
+					int low_i = Low(result_boundary_m, i);
+					while (low_i != -1 && pivot[low_i] != -1) {
+						int j = pivot[low_i];
+						for (int k = 0; k <= low_i; k++) {
+							result_boundary_m[k][i] ^= result_boundary_m[k][j];
+						}
+						if (memory_m) {
+							for (int k = 0; k < Rows(*memory_m); k++) {
+								(*memory_m)[k][i] ^= (*memory_m)[k][j];
+							}
+						}
+						low_i = Low(result_boundary_m, i);
+					}
+					if (low_i != -1) pivot[low_i] = i;
+				}
+				return result_boundary_m;
+			}
+			for (int i = 0; i < Cols(result_boundary_m); i++) {
+				bool end_loop = false;
+				while (!end_loop) {
+					end_loop = true;
+					for (int j = 0; j < i; j++) {
 						int low_i = Low(result_boundary_m, i);
 						int low_j = Low(result_boundary_m, j);
 						if (low_i==low_j && low_i!=-1) {
@@ -549,11 +1594,13 @@ namespace zq{
 								i,
 								MatrixGetCol(result_boundary_m, i) ^ MatrixGetCol(result_boundary_m, j)
 							);
-							MatrixSetCol(
-								memory_m,
-								i,
-								MatrixGetCol(memory_m, i) ^ MatrixGetCol(memory_m, j)
-							);
+							if (memory_m) {
+								MatrixSetCol(
+									*memory_m,
+									i,
+									MatrixGetCol(*memory_m, i) ^ MatrixGetCol(*memory_m, j)
+								);
+							}
 							end_loop = false;
 						}
 					}
@@ -563,12 +1610,53 @@ namespace zq{
 			return result_boundary_m;
 		}
 
+		/**
+			Sparse version, memory_m is the transposed V matrix
+		*/
+		static SparseMatrixLIL<int> ReduceBoundaryMatrix_Echelon(
+			const SparseMatrixLIL<int>& boundary_m,
+			SparseMatrixLIL<int>& memory_m,
+			ReductionType type = ReductionType::STANDARD
+		) {
+			return _ReduceBoundaryMatrix_Echelon(boundary_m, &memory_m, type);
+		}
+
 		static SparseMatrixLIL<int> ReduceBoundaryMatrix_Echelon(
 			const SparseMatrixLIL<int>& boundary_m,
-			SparseMatrixLIL<int>& memory_m
+			ReductionType type = ReductionType::STANDARD
+		) {
+			return _ReduceBoundaryMatrix_Echelon(boundary_m, (SparseMatrixLIL<int>*)nullptr, type);
+		}
+
+		static SparseMatrixLIL<int> _ReduceBoundaryMatrix_Echelon(
+			const SparseMatrixLIL<int>& boundary_m,
+			SparseMatrixLIL<int>* memory_m,
+			ReductionType type
 		) {
 			SparseMatrixLIL<int> result_boundary_m = boundary_m;
-			memory_m = SparseMatrixLIL<int>::IndentityMatrix(result_boundary_m.row_num, result_boundary_m.col_num);
+			if (memory_m) *memory_m = SparseMatrixLIL<int>::IndentityMatrix(result_boundary_m.row_num, result_boundary_m.col_num);
+			if (type == ReductionType::STANDARD) {
+				Array<int> pivot(result_boundary_m.col_num, -1);
+				for (int i = 0; i < result_boundary_m.row_num; i++) {
+					int low_i = Low(result_boundary_m, i);
+					while (low_i != -1 && pivot[low_i] != -1) {
+						int j = pivot[low_i];
+						result_boundary_m.SetSparseRow(
+							result_boundary_m.GetSparseRow(i) ^ result_boundary_m.GetSparseRow(j)
+							, i
+						);
+						if (memory_m) {
+							memory_m->SetSparseRow(
+								memory_m->GetSparseRow(i) ^ memory_m->GetSparseRow(j)
+								, i
+							);
+						}
+						low_i = Low(result_boundary_m, i);
+					}
+					if (low_i != -1) pivot[low_i] = i;
+				}
+				return result_boundary_m;
+			}
 			for (int i = 0; i < result_boundary_m.row_num; i++) {
 				bool end_loop = false;
 				while (!end_loop) {
@@ -582,10 +1670,12 @@ namespace zq{
 								result_boundary_m.GetSparseRow(i) ^ result_boundary_m.GetSparseRow(j)
 								, i
 							);
-							memory_m.SetSparseRow(
-								memory_m.GetSparseRow(i) ^ memory_m.GetSparseRow(j)
-								, i
-							);
+							if (memory_m) {
+								memory_m->SetSparseRow(
+									memory_m->GetSparseRow(i) ^ memory_m->GetSparseRow(j)
+									, i
+								);
+							}
 							end_loop = false;
 						}
 					}
@@ -624,6 +1714,57 @@ namespace zq{
 			return true;
 		}
 		
+		/**
+			For each simplex of nchain, find the indices in pchain of its facets,
+			which are enumerated by removing one vertex and looked up in a hash
+			of pchain, so the cost is linear in the number of simplices.
+			faces[j] is sorted increasingly. The simplices of pchain are assumed
+			to be unique. Return whether every facet is found in pchain.
+		*/
+		static bool FacetIndex(
+			const Array<Simplex<int>>& pchain,
+			const Array<Simplex<int>>& nchain,
+			Array<Array<int>>& faces
+		) {
+			std::unordered_map<SimplexKey, int> pchain_map;
+			pchain_map.reserve(pchain.size());
+			for (int i = 0; i < pchain.size(); i++) {
+				SimplexKey key(pchain[i]);
+				std::sort(key.Data(), key.Data() + key.count);
+				pchain_map.insert(std::pair<SimplexKey, int>(key, i));
+			}
+			faces.resize(nchain.size());
+			int closed = 1;
+#pragma omp parallel for reduction(&&:closed)
+			for (int j = 0; j < nchain.size(); j++) {
+				int inline_points[ZQ_SIMPLEX_KEY_CAPACITY + 1];
+				Array<int> spill_points;
+				int dim = nchain[j].Dim();
+				int* sorted_points = inline_points;
+				if (dim > ZQ_SIMPLEX_KEY_CAPACITY + 1) {
+					spill_points.resize(dim);
+					sorted_points = get_ptr(spill_points);
+				}
+				for (int l = 0; l < dim; l++) sorted_points[l] = nchain[j].points[l];
+				std::sort(sorted_points, sorted_points + dim);
+				SimplexKey facet;
+				faces[j].clear();
+				if (dim <= 1) continue;
+				facet.Resize(dim - 1);
+				int* facet_points = facet.Data();
+				for (int k = 0; k < dim; k++) {
+					for (int l = 0, m = 0; l < dim; l++) {
+						if (l != k) facet_points[m++] = sorted_points[l];
+					}
+					auto iter = pchain_map.find(facet);
+					if (iter != pchain_map.end()) faces[j].push_back(iter->second);
+					else closed = 0;
+				}
+				std::sort(faces[j].begin(), faces[j].end());
+			}
+			return closed != 0;
+		}
+
 		static DenseMatrix<int> BoundaryMatrix(
 			const Array<Simplex<int>>& pchain,
 			const Array<Simplex<int>>& nchain
@@ -633,12 +1774,12 @@ namespace zq{
 				return DenseMatrix<int>(1, nchain.size());
 			}
 			DenseMatrix<int> boudary_m(pchain.size(), nchain.size());
-			for (int i = 0; i < pchain.size(); i++) {
-				for (int j = 0; j < nchain.size(); j++) {
-					if (CheckFace(pchain[i], nchain[j])) {
-						boudary_m[i][j] = 1;
-					}
-					else boudary_m[i][j] = 0;
+			Array<Array<int>> faces;
+			FacetIndex(pchain, nchain, faces);
+#pragma omp parallel for
+			for (int j = 0; j < nchain.size(); j++) {
+				for (int k = 0; k < faces[j].size(); k++) {
+					boudary_m[faces[j][k]][j] = 1;
 				}
 			}
 			return boudary_m;
@@ -649,16 +1790,19 @@ namespace zq{
 			const Array<Simplex<int>>& nchain
 		) {
 			//special -1
+			if (nchain.size() == 0) {
+				return SparseMatrixLIL<int>();
+			}
 			if (pchain.size() == 0) {
 				return SparseMatrixLIL<int>(nchain.size(),1 );
 			}
 			SparseMatrixLIL<int> boudary_m(nchain.size(), pchain.size());
+			Array<Array<int>> faces;
+			FacetIndex(pchain, nchain, faces);
+#pragma omp parallel for
 			for (int i = 0; i < nchain.size(); i++) {
-				for (int j = 0; j < pchain.size(); j++) {
-					if (CheckFace(pchain[j], nchain[i])) {
-						boudary_m.InsertElement(1, i, j);
-					}
-				}
+				boudary_m.rows[i].swap(faces[i]);
+				boudary_m.value[i].assign(boudary_m.rows[i].size(), 1);
 			}
 			return boudary_m;
 		}
@@ -747,88 +1891,1517 @@ namespace zq{
 			}
 		}
 
+		/**
+			Over Z2 the Smith normal form only depends on the rank, so the
+			block from cur on is eliminated by RankZ2 without recursion, and
+			the normal form is written back. The matrix is transposed, each
+			row is a column of the boundary matrix.
+		*/
 		static int _Recusive_SmithNorm(
 			SparseMatrixLIL<int>& boundary_m,
 			int cur
 		) {
-			throw "incomplete";
+			Z2BoundaryMatrix<Z2ListColumn> block(myMax(boundary_m.row_num - cur, 0));
+			Array<int> entries;
+			for (int i = cur; i < boundary_m.row_num; i++) {
+				entries.clear();
+				for (int j = 0; j < boundary_m.rows[i].size(); j++) {
+					if (boundary_m.rows[i][j] >= cur) entries.push_back(boundary_m.rows[i][j]);
+				}
+				block.SetColumn(i - cur, entries);
+			}
+			int rank = cur + RankZ2(block);
+			for (int i = cur; i < boundary_m.row_num; i++) {
+				boundary_m.rows[i].clear();
+				boundary_m.value[i].clear();
+				if (i < rank) {
+					boundary_m.rows[i].push_back(i);
+					boundary_m.value[i].push_back(1);
+				}
+			}
+			return rank;
 		}
 		// Persistent Homology — a Survey, Herbert Edelsbrunnerand John Harer
 	};
-	
+
 	/**
-		Helper function for VR complex construction
+		Filtered complex: every simplex is stored once together with its
+		filtration value, instead of one Simplical_Complex per epsilon.
+		After Sort(), simplex is in filtration order (value > dim > points
+		content) and simplex[i].simplex_index is i. The value of a simplex
+		should not be smaller than the values of its faces.
 	*/
-	void _FindSubsets(
-		Array<int>& subset,
-		const Array<int>& index_set,
-		int k,
-		int start,
-		const std::function<bool(const Array<int>&)>& filter,
-		Array<Array<int>>& results
-	) {
-		//printf("_FindSubsets, subset.size():%d,k:%d,start:%d\n", subset.size(), k, start);
-		if (!filter(subset)) return;
-		if (subset.size() == k) {
-			results.push_back(subset);
-			return;
+	template<typename T>
+	class FilteredComplex {
+	public:
+		Array<T> points;
+		Array<Simplex<int>> simplex;
+		Array<float> value;
+		FilteredComplex() {}
+
+		template<typename TYPE> FilteredComplex(const TYPE* data, int dim_num) {
+			points.resize(dim_num);
+			points.assign(data, data + dim_num);
 		}
-		for (int i = start; i < index_set.size(); i++) {
-			subset.push_back(index_set[i]);
-			_FindSubsets(subset, index_set, k, i + 1, filter, results);
-			subset.pop_back();
+
+	public:
+		/**
+			the vertices of the simplex are sorted before it is stored
+		*/
+		void AddSimplex(const Array<int>& simplex_raw, float val) {
+			Array<int> sorted_points = simplex_raw;
+			std::sort(sorted_points.begin(), sorted_points.end());
+			simplex.push_back(Simplex<int>(sorted_points));
+			value.push_back(val);
 		}
-	}
 
-	/**
-		Helper function for VR complex construction
-	*/
-	void FilterTuples(
-		const Array<int>& index_set,
-		const std::function<bool(const Array<int>&)>& filter,
-		int k,
-		Array<Array<int>>& results
-	) {
-		Array<int> subset;
-		_FindSubsets(subset, index_set, k, 0, filter, results);
-	}
+		void AddSimplex(const Simplex<int>& simplex_raw, float val) {
+			AddSimplex(simplex_raw.points, val);
+		}
 
-	// Calculate Distance Function, which is provided for you to define by yourself
-	template<typename Type>
-	float Distance(const Type& p1, const Type& p2) {
-		return (p1 - p2).Length();
-	}
-	
-	// Afra Zomorodian algorithm: find the VR complex
-	// Note: This function is not suitable for complex with high dimensional
-	/**
-		Construct VR complex for discrete points
-	*/
-	template<typename ParaType, typename PointType>
-	void VRComplexConstruct(
-		const ParaType& epsilon,
-		const Array<PointType>& points,
-		int k,
-		Array<Array<int>>& results
-	) {
-		Array<int> index_set(points.size());
-		for (int i = 0; i < index_set.size(); i++) index_set[i] = i;
-		std::function<bool(const Array<int>&)> filter = [&](const Array<int>& index) {
-			for (int i = 0; i < index.size(); i++) {
-				for (int j = i + 1; j < index.size(); j++) {
-					//std::cout<<points[i] << ","<< points[j] << "," << epsilon<<"\t";
-					//printf("%f,%f\t", Distance(points[index[i]], points[index[j]]), epsilon);
-					if (Distance(points[index[i]], points[index[j]]) > epsilon) return false;
-				}
-			}
-			return true;
-		};
-		//printf("points.size():%d\n", points.size());
-		for (int i = 1; i <= k; i++) {
-			FilterTuples(index_set, filter, i, results);
+		int SimplexNumber() const {
+			return simplex.size();
 		}
-		//printf("results.size():%d\n", results.size());
-	}
+
+		int Dim() const {
+			return points.size();
+		}
+
+		/**
+			Sort the simplices into filtration order
+		*/
+		void Sort() {
+			Array<int> order(simplex.size());
+			for (int i = 0; i < order.size(); i++) order[i] = i;
+			std::sort(order.begin(), order.end(), [&](int a, int b) {
+				if (value[a] != value[b]) return value[a] < value[b];
+				if (simplex[a].Dim() != simplex[b].Dim()) return simplex[a].Dim() < simplex[b].Dim();
+				return simplex[a].points < simplex[b].points;
+			});
+			Array<Simplex<int>> sorted_simplex(simplex.size());
+			Array<float> sorted_value(value.size());
+			for (int i = 0; i < order.size(); i++) {
+				sorted_simplex[i] = simplex[order[i]];
+				sorted_simplex[i].simplex_index = i;
+				sorted_value[i] = value[order[i]];
+			}
+			simplex.swap(sorted_simplex);
+			value.swap(sorted_value);
+		}
+
+		/**
+			Boundary matrix in filtration order, the faces of each simplex
+			are found by removing one vertex and looking the facet up.
+			Sort() should be called first.
+		*/
+		template<class Column = Z2HeapColumn>
+		Z2BoundaryMatrix<Column> BoundaryMatrixZ2() const {
+			Array<Array<int>> faces;
+			if (!Simplical_Complex<T>::FacetIndex(simplex, simplex, faces)) {
+				throw "the complex is not closed under faces";
+			}
+			Z2BoundaryMatrix<Column> boundary_m(simplex.size());
+			for (int i = 0; i < simplex.size(); i++) {
+				boundary_m.SetColumn(i, faces[i]);
+				boundary_m.dims[i] = simplex[i].Dim();
+			}
+			return boundary_m;
+		}
+
+		/**
+			Persistence pairs as indices of simplex, death is -1 for the
+			essential classes. Sort() should be called first. With
+			morse_reduction the matrix of the Morse complex is reduced instead.
+		*/
+		void PersistencePairs(
+			Array<std::pair<int, int>>& interval,
+			ReductionType type = ReductionType::TWIST,
+			bool morse_reduction = false
+		) const {
+			Z2BoundaryMatrix<> boundary_m = BoundaryMatrixZ2();
+			if (morse_reduction) {
+				Simplical_Complex<T>::MorsePersistenceIntervals(boundary_m, value, interval, type);
+			}
+			else {
+				Simplical_Complex<T>::PersistenceIntervals(boundary_m, interval, type);
+			}
+		}
+
+		/**
+			Persistence pairs as PersistencePairs, with a representative
+			cycle of each interval as indices of simplex. The cycles come
+			from the boundary matrix, so COHOMOLOGY is reduced as TWIST.
+		*/
+		void PersistenceCycles(
+			Array<std::pair<int, int>>& interval,
+			Array<Array<int>>& cycles,
+			ReductionType type = ReductionType::TWIST
+		) const {
+			Z2BoundaryMatrix<> boundary_m = BoundaryMatrixZ2();
+			boundary_m.TrackAdditions();
+			if (type == ReductionType::COHOMOLOGY) type = ReductionType::TWIST;
+			Simplical_Complex<T>::PersistenceIntervals(boundary_m, interval, type);
+			Simplical_Complex<T>::RepresentativeCycles(boundary_m, interval, cycles);
+		}
+
+		/**
+			Convert from the old representation, one complex per epsilon.
+			The value of a simplex is the epsilon at which it first appears.
+		*/
+		static FilteredComplex FromComplexList(
+			const Array<float>& epsilon_list,
+			Array<Simplical_Complex<T>>& complex_list
+		) {
+			Simplical_Complex<T>::template AssignSimplexIndex<T>(complex_list);
+			const Simplical_Complex<T>& final_complex = complex_list[complex_list.size() - 1];
+			FilteredComplex result;
+			result.points = final_complex.points;
+			for (int i = 0; i < final_complex.simplex.size(); i++) {
+				result.AddSimplex(final_complex.simplex[i], epsilon_list[final_complex.simplex[i].simplex_index]);
+			}
+			result.Sort();
+			return result;
+		}
+	};
+
+	/**
+		Simplex tree (Boissonnat and Maria): a trie over the sorted vertex
+		lists of the simplices. Every node is a simplex whose vertices are the
+		labels on its path from the root, so simplices sharing a prefix share
+		their nodes. Children are sorted by label, a simplex with d vertices is
+		found with d binary searches. Inserting a simplex inserts all its faces,
+		and the value of a face is lowered to the value of the simplex when
+		needed, so the filtration stays monotone.
+	*/
+	template<typename T>
+	class SimplexTree {
+	public:
+		class Node {
+		public:
+			int label = -1;
+			int parent = -1;
+			int depth = 0;		/// number of vertices
+			int index = -1;		/// position in chains[depth - 1]
+			float value = 0;
+			Array<int> children;	/// sorted by label
+		};
+		Array<T> points;
+		Array<Node> nodes;				/// nodes[0] is the root, the empty simplex
+		Array<Array<int>> chains;		/// chains[n] are the nodes of the n-simplices
+		Array<Array<int>> label_nodes;	/// nodes by their last vertex, used for cofaces
+		SimplexTree() {
+			nodes.resize(1);
+		}
+
+		template<typename TYPE> SimplexTree(const TYPE* data, int dim_num) : SimplexTree() {
+			points.resize(dim_num);
+			points.assign(data, data + dim_num);
+		}
+
+	public:
+		int SimplexNumber() const {
+			return nodes.size() - 1;
+		}
+
+		int Dim() const {
+			return points.size();
+		}
+
+		/// the largest number of vertices of a simplex
+		int MaxDim() const {
+			return chains.size();
+		}
+
+		int NodeDim(int node) const {
+			return nodes[node].depth;
+		}
+
+		float Value(int node) const {
+			return nodes[node].value;
+		}
+
+		/// return -1 if node has no child with this label
+		int Child(int node, int label) const {
+			const Array<int>& children = nodes[node].children;
+			auto iter = std::lower_bound(children.begin(), children.end(), label, [&](int c, int l) {
+				return nodes[c].label < l;
+			});
+			if (iter != children.end() && nodes[*iter].label == label) return *iter;
+			return -1;
+		}
+
+		/// vertices should be sorted increasingly, return -1 if not found
+		int Find(const int* vertices, int num, int start = 0) const {
+			int node = start;
+			for (int i = 0; i < num && node != -1; i++) {
+				node = Child(node, vertices[i]);
+			}
+			return node;
+		}
+
+		int Find(const Array<int>& simplex_raw) const {
+			Array<int> sorted_points = simplex_raw;
+			std::sort(sorted_points.begin(), sorted_points.end());
+			return Find(get_ptr(sorted_points), sorted_points.size());
+		}
+
+		/**
+			Insert the simplex and all its faces, return the node of the simplex
+		*/
+		int Insert(const Array<int>& simplex_raw, float val) {
+			Array<int> sorted_points = simplex_raw;
+			std::sort(sorted_points.begin(), sorted_points.end());
+			_InsertFaces(0, sorted_points, 0, val);
+			return Find(get_ptr(sorted_points), sorted_points.size());
+		}
+
+		int Insert(const Simplex<int>& simplex_raw, float val) {
+			return Insert(simplex_raw.points, val);
+		}
+
+		/**
+			Insert the simplex without visiting its faces, return its node.
+			vertices should be sorted increasingly and its prefix without the
+			last vertex should be in the tree, so only one node is created.
+			The caller keeps the tree closed under faces, as clique expansion
+			does by emitting each clique after its prefix.
+		*/
+		int InsertPath(const Array<int>& vertices, float val) {
+			int node = 0;
+			for (int i = 0; i < vertices.size(); i++) {
+				node = _FindOrCreateChild(node, vertices[i], val);
+			}
+			nodes[node].value = myMin(nodes[node].value, val);
+			return node;
+		}
+
+		void Vertices(int node, Array<int>& vertices) const {
+			vertices.resize(nodes[node].depth);
+			for (int i = nodes[node].depth - 1; i >= 0; i--) {
+				vertices[i] = nodes[node].label;
+				node = nodes[node].parent;
+			}
+		}
+
+		Simplex<int> GetSimplex(int node) const {
+			Array<int> vertices;
+			Vertices(node, vertices);
+			return Simplex<int>(vertices);
+		}
+
+		/**
+			Facets of the node, facets[k] drops the k-th vertex. The search
+			starts from the ancestor holding the vertices before k.
+		*/
+		void Facets(int node, Array<int>& facets) const {
+			int depth = nodes[node].depth;
+			facets.clear();
+			if (depth <= 1) return;
+			Array<int> path(depth), vertices(depth);
+			for (int i = depth - 1, cur = node; i >= 0; i--, cur = nodes[cur].parent) {
+				path[i] = cur;
+				vertices[i] = nodes[cur].label;
+			}
+			for (int k = 0; k < depth; k++) {
+				int start = k == 0 ? 0 : path[k - 1];
+				facets.push_back(Find(get_ptr(vertices) + k + 1, depth - k - 1, start));
+			}
+		}
+
+		/**
+			Cofaces of the node with one more vertex. Those whose new vertex
+			is larger than the last one are its children, the others end with
+			the same label, and are searched in label_nodes.
+		*/
+		void Cofaces(int node, Array<int>& cofaces) const {
+			cofaces = nodes[node].children;
+			if (node == 0) return;
+			int depth = nodes[node].depth;
+			Array<int> vertices, coface_vertices;
+			Vertices(node, vertices);
+			const Array<int>& candidates = label_nodes[nodes[node].label];
+			for (int i = 0; i < candidates.size(); i++) {
+				if (nodes[candidates[i]].depth != depth + 1) continue;
+				Vertices(candidates[i], coface_vertices);
+				if (std::includes(coface_vertices.begin(), coface_vertices.end(), vertices.begin(), vertices.end())) {
+					cofaces.push_back(candidates[i]);
+				}
+			}
+		}
+
+		/**
+			nodes of the n-simplices, that is with n + 1 vertices
+		*/
+		const Array<int>& ChainNodes(int n) const {
+			static const Array<int> empty;
+			if (n < 0 || n >= chains.size()) return empty;
+			return chains[n];
+		}
+
+		/**
+			return all n-chains of the complex simplex
+		*/
+		void NChain(int n, Array<Simplex<int>>& result) const {
+			const Array<int>& chain = ChainNodes(n);
+			for (int i = 0; i < chain.size(); i++) {
+				result.push_back(GetSimplex(chain[i]));
+			}
+		}
+
+		/**
+			Boundary matrix from the p-chain to the n-chain, transposed as
+			Simplical_Complex::BoundaryMatrixSparse, n should be p + 1
+		*/
+		SparseMatrixLIL<int> BoundaryMatrixSparse(int p, int n) const {
+			if (n != p + 1) {
+				throw "n should be p + 1";
+			}
+			const Array<int>& pchain = ChainNodes(p);
+			const Array<int>& nchain = ChainNodes(n);
+			//special -1
+			if (nchain.size() == 0) {
+				return SparseMatrixLIL<int>();
+			}
+			if (pchain.size() == 0) {
+				return SparseMatrixLIL<int>(nchain.size(), 1);
+			}
+			SparseMatrixLIL<int> boudary_m(nchain.size(), pchain.size());
+#pragma omp parallel for
+			for (int i = 0; i < nchain.size(); i++) {
+				Array<int> facets;
+				Facets(nchain[i], facets);
+				for (int k = 0; k < facets.size(); k++) {
+					boudary_m.rows[i].push_back(nodes[facets[k]].index);
+				}
+				std::sort(boudary_m.rows[i].begin(), boudary_m.rows[i].end());
+				boudary_m.value[i].assign(boudary_m.rows[i].size(), 1);
+			}
+			return boudary_m;
+		}
+
+		/**
+			Betti numbers, with the same convention as Simplical_Complex::BettiNumber
+		*/
+		Array<int> BettiNumber(int n = -1) const {
+			if (n == -1) n = chains.size();
+			Array<int> rank(n + 1, 0);
+			Array<int> nullity(n + 1, 0);
+			for (int j = 0; j < n && j < chains.size(); j++) {
+				SparseMatrixLIL<int> boundary_m = BoundaryMatrixSparse(j - 1, j);
+				Simplical_Complex<T>::ReduceBoundaryMatrix_SmithNorm(boundary_m, rank[j], nullity[j]);
+			}
+			Array<int> betti(n);
+			for (int i = 0; i < n - 1; i++) {
+				betti[i] = nullity[i] - rank[i + 1];
+			}
+			return betti;
+		}
+
+		/**
+			All simplices in filtration order (value > dim > points content),
+			the same order as FilteredComplex::Sort. The preorder of the trie
+			is the lexicographic order of the vertex lists.
+		*/
+		void FiltrationOrder(Array<int>& order) const {
+			Array<int> preorder(nodes.size());
+			Array<int> stack(1, 0);
+			for (int count = 0; !stack.empty();) {
+				int node = stack.back();
+				stack.pop_back();
+				preorder[node] = count++;
+				const Array<int>& children = nodes[node].children;
+				stack.insert(stack.end(), children.rbegin(), children.rend());
+			}
+			order.resize(nodes.size() - 1);
+			for (int i = 0; i < order.size(); i++) order[i] = i + 1;
+			std::sort(order.begin(), order.end(), [&](int a, int b) {
+				if (nodes[a].value != nodes[b].value) return nodes[a].value < nodes[b].value;
+				if (nodes[a].depth != nodes[b].depth) return nodes[a].depth < nodes[b].depth;
+				return preorder[a] < preorder[b];
+			});
+		}
+
+		/**
+			Boundary matrix whose columns are the nodes of order
+		*/
+		template<class Column = Z2HeapColumn>
+		Z2BoundaryMatrix<Column> BoundaryMatrixZ2(const Array<int>& order) const {
+			Array<int> position(nodes.size(), -1);
+			for (int i = 0; i < order.size(); i++) position[order[i]] = i;
+			Array<Array<int>> faces(order.size());
+#pragma omp parallel for
+			for (int i = 0; i < order.size(); i++) {
+				Facets(order[i], faces[i]);
+				for (int k = 0; k < faces[i].size(); k++) faces[i][k] = position[faces[i][k]];
+				std::sort(faces[i].begin(), faces[i].end());
+			}
+			Z2BoundaryMatrix<Column> boundary_m(order.size());
+			for (int i = 0; i < order.size(); i++) {
+				boundary_m.SetColumn(i, faces[i]);
+				boundary_m.dims[i] = nodes[order[i]].depth;
+			}
+			return boundary_m;
+		}
+
+		/**
+			Persistence pairs as positions in order, which is filled with
+			FiltrationOrder. death is -1 for the essential classes.
+			morse_reduction as FilteredComplex::PersistencePairs.
+		*/
+		void PersistencePairs(
+			Array<std::pair<int, int>>& interval,
+			Array<int>& order,
+			ReductionType type = ReductionType::TWIST,
+			bool morse_reduction = false
+		) const {
+			FiltrationOrder(order);
+			Z2BoundaryMatrix<> boundary_m = BoundaryMatrixZ2(order);
+			if (morse_reduction) {
+				Array<float> order_value(order.size());
+				for (int i = 0; i < order.size(); i++) order_value[i] = nodes[order[i]].value;
+				Simplical_Complex<T>::MorsePersistenceIntervals(boundary_m, order_value, interval, type);
+			}
+			else {
+				Simplical_Complex<T>::PersistenceIntervals(boundary_m, interval, type);
+			}
+		}
+
+		void ToFilteredComplex(FilteredComplex<T>& complex) const {
+			complex.points = points;
+			Array<int> vertices;
+			for (int i = 1; i < nodes.size(); i++) {
+				Vertices(i, vertices);
+				complex.AddSimplex(vertices, nodes[i].value);
+			}
+			complex.Sort();
+		}
+
+	protected:
+		void _InsertFaces(int node, const Array<int>& vertices, int start, float val) {
+			for (int i = start; i < vertices.size(); i++) {
+				int child = _FindOrCreateChild(node, vertices[i], val);
+				nodes[child].value = myMin(nodes[child].value, val);
+				_InsertFaces(child, vertices, i + 1, val);
+			}
+		}
+
+		int _FindOrCreateChild(int node, int label, float val) {
+			const Array<int>& children = nodes[node].children;
+			int pos = std::lower_bound(children.begin(), children.end(), label, [&](int c, int l) {
+				return nodes[c].label < l;
+			}) - children.begin();
+			if (pos < children.size() && nodes[children[pos]].label == label) return children[pos];
+			Node child;
+			child.label = label;
+			child.parent = node;
+			child.depth = nodes[node].depth + 1;
+			child.value = val;
+			int id = nodes.size();
+			if (chains.size() < child.depth) chains.resize(child.depth);
+			child.index = chains[child.depth - 1].size();
+			chains[child.depth - 1].push_back(id);
+			if (label_nodes.size() <= label) label_nodes.resize(label + 1);
+			label_nodes[label].push_back(id);
+			nodes.push_back(std::move(child));
+			nodes[node].children.insert(nodes[node].children.begin() + pos, id);
+			return id;
+		}
+	};
+	
+	/**
+		Helper function for VR complex construction
+	*/
+	void _FindSubsets(
+		Array<int>& subset,
+		const Array<int>& index_set,
+		int k,
+		int start,
+		const std::function<bool(const Array<int>&)>& filter,
+		Array<Array<int>>& results
+	) {
+		//printf("_FindSubsets, subset.size():%d,k:%d,start:%d\n", subset.size(), k, start);
+		if (!filter(subset)) return;
+		if (subset.size() == k) {
+			results.push_back(subset);
+			return;
+		}
+		for (int i = start; i < index_set.size(); i++) {
+			subset.push_back(index_set[i]);
+			_FindSubsets(subset, index_set, k, i + 1, filter, results);
+			subset.pop_back();
+		}
+	}
+
+	/**
+		Helper function for VR complex construction
+	*/
+	void FilterTuples(
+		const Array<int>& index_set,
+		const std::function<bool(const Array<int>&)>& filter,
+		int k,
+		Array<Array<int>>& results
+	) {
+		Array<int> subset;
+		_FindSubsets(subset, index_set, k, 0, filter, results);
+	}
+
+	// Calculate Distance Function, which is provided for you to define by yourself
+	template<typename Type>
+	float Distance(const Type& p1, const Type& p2) {
+		return (p1 - p2).Length();
+	}
+	
+	// Afra Zomorodian algorithm: find the VR complex
+	// Note: This function is not suitable for complex with high dimensional
+	/**
+		Construct VR complex for discrete points
+	*/
+	template<typename ParaType, typename PointType>
+	void VRComplexConstruct(
+		const ParaType& epsilon,
+		const Array<PointType>& points,
+		int k,
+		Array<Array<int>>& results
+	) {
+		Array<int> index_set(points.size());
+		for (int i = 0; i < index_set.size(); i++) index_set[i] = i;
+		std::function<bool(const Array<int>&)> filter = [&](const Array<int>& index) {
+			for (int i = 0; i < index.size(); i++) {
+				for (int j = i + 1; j < index.size(); j++) {
+					//std::cout<<points[i] << ","<< points[j] << "," << epsilon<<"\t";
+					//printf("%f,%f\t", Distance(points[index[i]], points[index[j]]), epsilon);
+					if (Distance(points[index[i]], points[index[j]]) > epsilon) return false;
+				}
+			}
+			return true;
+		};
+		//printf("points.size():%d\n", points.size());
+		for (int i = 1; i <= k; i++) {
+			FilterTuples(index_set, filter, i, results);
+		}
+		//printf("results.size():%d\n", results.size());
+	}
+
+	/**
+		Undirected graph stored as CSR adjacency: the neighbors of vertex i
+		are adj[offset[i]], ..., adj[offset[i+1]-1] in increasing order, and
+		weight is the length of each of these edges
+	*/
+	class NeighborGraph {
+	public:
+		Array<int> offset;
+		Array<int> adj;
+		Array<float> weight;
+	public:
+		int VertexNumber() const {
+			if (offset.size() == 0) return 0;
+			return offset.size() - 1;
+		}
+		int EdgeNumber() const {
+			return adj.size() / 2;
+		}
+		int Degree(int i) const {
+			return offset[i + 1] - offset[i];
+		}
+		const int* Neighbors(int i) const {
+			return get_ptr(adj) + offset[i];
+		}
+		/**
+			length of edge (i,j), -1 if i and j are not adjacent
+		*/
+		float Weight(int i, int j) const {
+			const int* begin = Neighbors(i);
+			const int* end = begin + Degree(i);
+			const int* iter = std::lower_bound(begin, end, j);
+			if (iter == end || *iter != j) return -1;
+			return weight[iter - get_ptr(adj)];
+		}
+		/**
+			build from the neighbor lists of each vertex, each list should
+			be sorted and contain both directions of an edge
+		*/
+		void Build(
+			const Array<Array<int>>& neighbors,
+			const Array<Array<float>>& neighbor_weight
+		) {
+			offset.resize(neighbors.size() + 1);
+			offset[0] = 0;
+			for (int i = 0; i < neighbors.size(); i++) {
+				offset[i + 1] = offset[i] + neighbors[i].size();
+			}
+			adj.resize(offset[neighbors.size()]);
+			weight.resize(offset[neighbors.size()]);
+#pragma omp parallel for
+			for (int i = 0; i < neighbors.size(); i++) {
+				std::copy(neighbors[i].begin(), neighbors[i].end(), adj.begin() + offset[i]);
+				std::copy(neighbor_weight[i].begin(), neighbor_weight[i].end(), weight.begin() + offset[i]);
+			}
+		}
+		/**
+			build from an edge list of n vertices, each edge is given once
+		*/
+		void Build(
+			int n,
+			const Array<std::pair<int, int>>& edges,
+			const Array<float>& edge_weight
+		) {
+			Array<Array<int>> neighbors(n);
+			Array<Array<float>> neighbor_weight(n);
+			for (int i = 0; i < edges.size(); i++) {
+				neighbors[edges[i].first].push_back(edges[i].second);
+				neighbors[edges[i].second].push_back(edges[i].first);
+			}
+#pragma omp parallel for
+			for (int i = 0; i < n; i++) {
+				std::sort(neighbors[i].begin(), neighbors[i].end());
+			}
+			for (int i = 0; i < n; i++) {
+				neighbor_weight[i].resize(neighbors[i].size());
+			}
+			Build(neighbors, neighbor_weight);
+			for (int i = 0; i < edges.size(); i++) {
+				int u = edges[i].first, v = edges[i].second;
+				weight[std::lower_bound(adj.begin() + offset[u], adj.begin() + offset[u + 1], v) - adj.begin()] = edge_weight[i];
+				weight[std::lower_bound(adj.begin() + offset[v], adj.begin() + offset[v + 1], u) - adj.begin()] = edge_weight[i];
+			}
+		}
+	};
+
+	/**
+		Build the epsilon-neighbor graph of the points once, two points are
+		adjacent when their Distance is not larger than epsilon
+	*/
+	template<typename ParaType, typename PointType>
+	void NeighborGraphConstruct(
+		const ParaType& epsilon,
+		const Array<PointType>& points,
+		NeighborGraph& graph
+	) {
+		int n = points.size();
+		Array<Array<int>> neighbors(n);
+		Array<Array<float>> neighbor_weight(n);
+#pragma omp parallel for schedule(dynamic, 16)
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < n; j++) {
+				if (j == i) continue;
+				float dist = Distance(points[i], points[j]);
+				if (dist <= epsilon) {
+					neighbors[i].push_back(j);
+					neighbor_weight[i].push_back(dist);
+				}
+			}
+		}
+		graph.Build(neighbors, neighbor_weight);
+	}
+
+	/**
+		kd-tree over the PointType::dims coordinates of the points, for the
+		k nearest neighbors. Candidates are measured by Distance, a subtree
+		is skipped when its splitting plane is farther than the current k-th
+		neighbor, which holds for the Euclidean Distance and any Minkowski one.
+	*/
+	template<typename PointType>
+	class PointKdTree {
+	public:
+		const Array<PointType>* points = nullptr;
+		Array<int> perm;	/// node mid of the range [lo, hi) is perm[mid], split along axis[mid]
+		Array<int> axis;
+	public:
+		void Build(const Array<PointType>& points) {
+			this->points = &points;
+			perm.resize(points.size());
+			axis.resize(points.size());
+			for (int i = 0; i < perm.size(); i++) perm[i] = i;
+			_Build(0, perm.size());
+		}
+
+		/**
+			the k nearest points of query as (distance, index), increasingly,
+			the query itself is included if it is one of the points
+		*/
+		void KNearest(const PointType& query, int k, Array<std::pair<float, int>>& nearest) const {
+			std::priority_queue<std::pair<float, int>> heap;
+			_Search(0, perm.size(), query, k, heap);
+			nearest.resize(heap.size());
+			for (int i = nearest.size() - 1; i >= 0; i--) {
+				nearest[i] = heap.top();
+				heap.pop();
+			}
+		}
+
+		/**
+			the indices of the points within Distance r of query
+		*/
+		void Radius(const PointType& query, float r, Array<int>& result) const {
+			result.clear();
+			_Range(0, perm.size(), query, r, result);
+		}
+
+	protected:
+		void _Build(int lo, int hi) {
+			if (lo >= hi) return;
+			const Array<PointType>& p = *points;
+			/// split along the widest coordinate of the range
+			int best_axis = 0;
+			float best_spread = -1;
+			for (int a = 0; a < PointType::dims; a++) {
+				float low = FLT_MAX, high = -FLT_MAX;
+				for (int i = lo; i < hi; i++) {
+					low = myMin(low, (float)p[perm[i]][a]);
+					high = myMax(high, (float)p[perm[i]][a]);
+				}
+				if (high - low > best_spread) {
+					best_spread = high - low;
+					best_axis = a;
+				}
+			}
+			int mid = (lo + hi) / 2;
+			std::nth_element(perm.begin() + lo, perm.begin() + mid, perm.begin() + hi, [&](int a, int b) {
+				return p[a][best_axis] < p[b][best_axis];
+			});
+			axis[mid] = best_axis;
+			_Build(lo, mid);
+			_Build(mid + 1, hi);
+		}
+
+		void _Search(int lo, int hi, const PointType& query, int k, std::priority_queue<std::pair<float, int>>& heap) const {
+			if (lo >= hi) return;
+			int mid = (lo + hi) / 2;
+			int id = perm[mid];
+			const PointType& p = (*points)[id];
+			float dist = Distance(query, p);
+			if (heap.size() < k) heap.push(std::make_pair(dist, id));
+			else if (dist < heap.top().first) {
+				heap.pop();
+				heap.push(std::make_pair(dist, id));
+			}
+			float offset = (float)query[axis[mid]] - (float)p[axis[mid]];
+			/// the side of the query first, the other only if the plane is close enough
+			if (offset < 0) {
+				_Search(lo, mid, query, k, heap);
+				if (heap.size() < k || -offset < heap.top().first) _Search(mid + 1, hi, query, k, heap);
+			}
+			else {
+				_Search(mid + 1, hi, query, k, heap);
+				if (heap.size() < k || offset < heap.top().first) _Search(lo, mid, query, k, heap);
+			}
+		}
+
+		void _Range(int lo, int hi, const PointType& query, float r, Array<int>& result) const {
+			if (lo >= hi) return;
+			int mid = (lo + hi) / 2;
+			int id = perm[mid];
+			const PointType& p = (*points)[id];
+			if (Distance(query, p) <= r) result.push_back(id);
+			float offset = (float)query[axis[mid]] - (float)p[axis[mid]];
+			if (offset <= r) _Range(lo, mid, query, r, result);
+			if (-offset <= r) _Range(mid + 1, hi, query, r, result);
+		}
+	};
+
+	/**
+		Distance to the empirical measure (Chazal, Cohen-Steiner and Merigot)
+		of every point: the quadratic mean of its distances to its k nearest
+		points, itself included, so k = 1 gives 0. The kNN is found once by
+		a PointKdTree, in parallel over the points.
+	*/
+	template<typename PointType>
+	void DTMWeights(
+		const Array<PointType>& points,
+		int k,
+		Array<float>& weight
+	) {
+		PointKdTree<PointType> tree;
+		tree.Build(points);
+		DTMWeights(tree, points, k, weight);
+	}
+
+	/**
+		DTMWeights with a PointKdTree already built on the points
+	*/
+	template<typename PointType>
+	void DTMWeights(
+		const PointKdTree<PointType>& tree,
+		const Array<PointType>& points,
+		int k,
+		Array<float>& weight
+	) {
+		int n = points.size();
+		weight.resize(n);
+#pragma omp parallel for schedule(dynamic, 64)
+		for (int i = 0; i < n; i++) {
+			Array<std::pair<float, int>> nearest;
+			tree.KNearest(points[i], k, nearest);
+			double sum = 0;
+			for (int j = 0; j < nearest.size(); j++) sum += (double)nearest[j].first * nearest[j].first;
+			weight[i] = (float)sqrt(sum / myMax((int)nearest.size(), 1));
+		}
+	}
+
+	/**
+		Helper function for edge collapse: whether edge (u,v) is dominated at
+		time t, that is some common neighbor w is adjacent to all the other
+		common neighbors, using only the edges not later than t
+	*/
+	inline bool _IsEdgeDominated(
+		const Array<std::unordered_map<int, float>>& current,
+		int u,
+		int v,
+		const Array<int>& common,
+		float t,
+		Array<int>& active
+	) {
+		active.clear();
+		for (int i = 0; i < common.size(); i++) {
+			if (current[u].at(common[i]) <= t && current[v].at(common[i]) <= t) {
+				active.push_back(common[i]);
+			}
+		}
+		for (int i = 0; i < active.size(); i++) {
+			const std::unordered_map<int, float>& w_nbr = current[active[i]];
+			bool dominate = true;
+			for (int j = 0; j < active.size() && dominate; j++) {
+				if (j == i) continue;
+				auto iter = w_nbr.find(active[j]);
+				dominate = iter != w_nbr.end() && iter->second <= t;
+			}
+			if (dominate) return true;
+		}
+		return false;
+	}
+
+	/**
+		Edge collapse of a flag filtration (Boissonnat and Pritam, Glisse and
+		Pritam). The edges are visited from the largest weight down. The
+		weight of an edge is raised to the first time it is not dominated in
+		the current graph, where the edges visited before have their new
+		weights and the others their original ones, and the edge is removed
+		if it stays dominated. The flag complex of collapsed has the same
+		persistence diagram as the flag complex of graph.
+	*/
+	inline void EdgeCollapse(
+		const NeighborGraph& graph,
+		NeighborGraph& collapsed
+	) {
+		int n = graph.VertexNumber();
+		Array<std::pair<int, int>> edges;
+		Array<float> edge_weight;
+		for (int u = 0; u < n; u++) {
+			for (int k = graph.offset[u]; k < graph.offset[u + 1]; k++) {
+				if (graph.adj[k] > u) {
+					edges.push_back(std::pair<int, int>(u, graph.adj[k]));
+					edge_weight.push_back(graph.weight[k]);
+				}
+			}
+		}
+		Array<int> order(edges.size());
+		for (int i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](int a, int b) {
+			if (edge_weight[a] != edge_weight[b]) return edge_weight[a] > edge_weight[b];
+			return a > b;
+		});
+		Array<std::unordered_map<int, float>> current(n);
+		for (int i = 0; i < edges.size(); i++) {
+			current[edges[i].first][edges[i].second] = edge_weight[i];
+			current[edges[i].second][edges[i].first] = edge_weight[i];
+		}
+		Array<std::pair<int, int>> kept_edges;
+		Array<float> kept_weight;
+		Array<int> common, active;
+		Array<float> times;
+		for (int i = 0; i < order.size(); i++) {
+			int u = edges[order[i]].first, v = edges[order[i]].second;
+			float val = edge_weight[order[i]];
+			const std::unordered_map<int, float>& small_nbr = current[u].size() < current[v].size() ? current[u] : current[v];
+			const std::unordered_map<int, float>& large_nbr = current[u].size() < current[v].size() ? current[v] : current[u];
+			common.clear();
+			for (auto iter = small_nbr.begin(); iter != small_nbr.end(); iter++) {
+				if (large_nbr.find(iter->first) != large_nbr.end()) common.push_back(iter->first);
+			}
+			/// the domination of (u,v) only changes when an edge between
+			/// u, v and their common neighbors appears
+			times.assign(1, val);
+			for (int j = 0; j < common.size(); j++) {
+				times.push_back(myMax(val, myMax(current[u].at(common[j]), current[v].at(common[j]))));
+				for (int l = j + 1; l < common.size(); l++) {
+					auto iter = current[common[j]].find(common[l]);
+					if (iter != current[common[j]].end()) times.push_back(myMax(val, iter->second));
+				}
+			}
+			std::sort(times.begin(), times.end());
+			times.erase(std::unique(times.begin(), times.end()), times.end());
+			bool removed = true;
+			for (int j = 0; j < times.size(); j++) {
+				if (!_IsEdgeDominated(current, u, v, common, times[j], active)) {
+					current[u][v] = current[v][u] = times[j];
+					kept_edges.push_back(std::pair<int, int>(u, v));
+					kept_weight.push_back(times[j]);
+					removed = false;
+					break;
+				}
+			}
+			if (removed) {
+				current[u].erase(v);
+				current[v].erase(u);
+			}
+		}
+		collapsed.Build(n, kept_edges, kept_weight);
+	}
+
+	/**
+		Helper function for clique expansion: grow simplex by each candidate,
+		the candidates of the new simplex are intersected with the upper
+		neighbors of the added vertex
+	*/
+	inline void _ExpandCliques(
+		const NeighborGraph& graph,
+		int k,
+		Array<int>& simplex,
+		float val,
+		const Array<int>& candidates,
+		Array<Array<int>>& results,
+		Array<float>& values
+	) {
+		results.push_back(simplex);
+		values.push_back(val);
+		if (simplex.size() == k) return;
+		Array<int> next_candidates;
+		for (int i = 0; i < candidates.size(); i++) {
+			int u = candidates[i];
+			float next_val = val;
+			for (int j = 0; j < simplex.size(); j++) {
+				next_val = myMax(next_val, graph.Weight(simplex[j], u));
+			}
+			next_candidates.clear();
+			const int* nbr = graph.Neighbors(u);
+			const int* nbr_end = nbr + graph.Degree(u);
+			std::set_intersection(
+				candidates.begin() + i + 1, candidates.end(),
+				std::upper_bound(nbr, nbr_end, u), nbr_end,
+				std::back_inserter(next_candidates)
+			);
+			simplex.push_back(u);
+			_ExpandCliques(graph, k, simplex, next_val, next_candidates, results, values);
+			simplex.pop_back();
+		}
+	}
+
+	/**
+		Enumerate all cliques of the graph with at most k vertices, in parallel
+		over the lowest vertex of each clique. values is the largest edge
+		weight of each clique.
+	*/
+	inline void CliqueExpansion(
+		const NeighborGraph& graph,
+		int k,
+		Array<Array<int>>& results,
+		Array<float>& values
+	) {
+		int n = graph.VertexNumber();
+		Array<Array<Array<int>>> local_results(n);
+		Array<Array<float>> local_values(n);
+#pragma omp parallel for schedule(dynamic, 16)
+		for (int v = 0; v < n; v++) {
+			const int* nbr = graph.Neighbors(v);
+			const int* nbr_end = nbr + graph.Degree(v);
+			Array<int> candidates(std::upper_bound(nbr, nbr_end, v), nbr_end);
+			Array<int> simplex(1, v);
+			_ExpandCliques(graph, k, simplex, 0, candidates, local_results[v], local_values[v]);
+		}
+		int total = 0;
+		for (int v = 0; v < n; v++) total += local_results[v].size();
+		results.reserve(results.size() + total);
+		values.reserve(values.size() + total);
+		for (int v = 0; v < n; v++) {
+			for (int i = 0; i < local_results[v].size(); i++) {
+				results.push_back(std::move(local_results[v][i]));
+			}
+			values.insert(values.end(), local_values[v].begin(), local_values[v].end());
+		}
+	}
+
+	/**
+		Construct VR complex for discrete points, the same as VRComplexConstruct,
+		but build the epsilon-neighbor graph once and expand its cliques
+	*/
+	template<typename ParaType, typename PointType>
+	void VRComplexConstructByClique(
+		const ParaType& epsilon,
+		const Array<PointType>& points,
+		int k,
+		Array<Array<int>>& results
+	) {
+		NeighborGraph graph;
+		NeighborGraphConstruct(epsilon, points, graph);
+		Array<Array<int>> cliques;
+		Array<float> values;
+		CliqueExpansion(graph, k, cliques, values);
+		/// same order as VRComplexConstruct: by size, then by content
+		std::sort(cliques.begin(), cliques.end(), [](const Array<int>& a, const Array<int>& b) {
+			if (a.size() != b.size()) return a.size() < b.size();
+			return a < b;
+		});
+		results.reserve(results.size() + cliques.size());
+		for (int i = 0; i < cliques.size(); i++) {
+			results.push_back(std::move(cliques[i]));
+		}
+	}
+
+	/**
+		Construct the VR filtration up to max_epsilon as one filtered complex,
+		the value of a simplex is the largest distance between its vertices.
+		With edge_collapse, the neighbor graph is collapsed by EdgeCollapse
+		before the cliques are expanded. The intervals of positive length
+		stay the same, except those born by simplices of k vertices, which
+		depend on the truncation at k anyway.
+	*/
+	template<typename PointType>
+	void VRFilteredComplexConstruct(
+		float max_epsilon,
+		const Array<PointType>& points,
+		int k,
+		FilteredComplex<PointType>& complex,
+		bool edge_collapse = false
+	) {
+		NeighborGraph graph;
+		NeighborGraphConstruct(max_epsilon, points, graph);
+		if (edge_collapse) {
+			NeighborGraph collapsed;
+			EdgeCollapse(graph, collapsed);
+			graph = collapsed;
+		}
+		Array<Array<int>> results;
+		Array<float> values;
+		CliqueExpansion(graph, k, results, values);
+		complex.points = points;
+		for (int i = 0; i < results.size(); i++) {
+			complex.AddSimplex(results[i], values[i]);
+		}
+		complex.Sort();
+	}
+
+	/**
+		Construct the DTM-weighted Rips filtration (Anai et al.) up to
+		max_epsilon as one filtered complex. The weight w of a point is its
+		DTMWeights with dtm_k neighbors. In the diameter convention of the VR
+		construction a vertex enters at 2w and an edge at
+		max(2w_i, 2w_j, |ij| + w_i + w_j), the weighted Rips with p = 1, and
+		a larger simplex at its longest edge. dtm_k = 1 gives the VR
+		filtration. Outliers get a large weight and enter late. One
+		PointKdTree gives both the weights and the edges, by range queries.
+	*/
+	template<typename PointType>
+	void DTMRipsFilteredComplexConstruct(
+		float max_epsilon,
+		const Array<PointType>& points,
+		int dtm_k,
+		int k,
+		FilteredComplex<PointType>& complex
+	) {
+		int n = points.size();
+		PointKdTree<PointType> tree;
+		tree.Build(points);
+		Array<float> weight;
+		DTMWeights(tree, points, dtm_k, weight);
+		/// an edge at j is never earlier than |ij| + w_j, so it lies within max_epsilon - w_j
+		Array<Array<std::pair<int, float>>> earlier(n);
+#pragma omp parallel for schedule(dynamic, 16)
+		for (int j = 0; j < n; j++) {
+			if (2 * weight[j] > max_epsilon) continue;
+			Array<int> near;
+			tree.Radius(points[j], max_epsilon - weight[j], near);
+			for (int t = 0; t < near.size(); t++) {
+				int i = near[t];
+				if (i >= j) continue;
+				float d = Distance(points[i], points[j]);
+				float val = myMax(myMax(2 * weight[i], 2 * weight[j]), d + weight[i] + weight[j]);
+				if (val <= max_epsilon) earlier[j].push_back(std::make_pair(i, val));
+			}
+		}
+		Array<std::pair<int, int>> edges;
+		Array<float> edge_value;
+		for (int j = 0; j < n; j++) {
+			for (int t = 0; t < earlier[j].size(); t++) {
+				edges.push_back(std::make_pair(earlier[j][t].first, j));
+				edge_value.push_back(earlier[j][t].second);
+			}
+		}
+		NeighborGraph graph;
+		graph.Build(n, edges, edge_value);
+		Array<Array<int>> results;
+		Array<float> values;
+		CliqueExpansion(graph, k, results, values);
+		complex.points = points;
+		for (int i = 0; i < results.size(); i++) {
+			if (results[i].size() == 1) {
+				values[i] = 2 * weight[results[i][0]];
+				if (values[i] > max_epsilon) continue;
+			}
+			complex.AddSimplex(results[i], values[i]);
+		}
+		complex.Sort();
+	}
+
+	/**
+		Greedy permutation (farthest point order) of the points: order[0] is
+		point 0, every next point is the farthest from those before it, and
+		radius[i] is that distance, the insertion radius of order[i]
+		(infinity for the first). Only the points closer to the new point
+		than to the points before can change their distance, and they lie
+		within its insertion radius, so one PointKdTree range query per point
+		replaces the pass over all points. The farthest point comes from a
+		max-heap with stale entries skipped.
+	*/
+	template<typename PointType>
+	void GreedyPermutation(
+		const Array<PointType>& points,
+		Array<int>& order,
+		Array<float>& radius
+	) {
+		int n = points.size();
+		order.clear();
+		radius.clear();
+		if (n == 0) return;
+		PointKdTree<PointType> tree;
+		tree.Build(points);
+		Array<float> dist(n);
+		Array<bool> chosen(n, false);
+#pragma omp parallel for
+		for (int i = 0; i < n; i++) dist[i] = Distance(points[i], points[0]);
+		std::priority_queue<std::pair<float, int>> heap;
+		for (int i = 1; i < n; i++) heap.push(std::make_pair(dist[i], i));
+		order.push_back(0);
+		radius.push_back(std::numeric_limits<float>::infinity());
+		chosen[0] = true;
+		Array<int> near;
+		while (!heap.empty()) {
+			std::pair<float, int> top = heap.top();
+			heap.pop();
+			int x = top.second;
+			if (chosen[x] || top.first != dist[x]) continue;
+			chosen[x] = true;
+			order.push_back(x);
+			radius.push_back(top.first);
+			tree.Radius(points[x], top.first, near);
+			for (int i = 0; i < near.size(); i++) {
+				int y = near[i];
+				if (chosen[y]) continue;
+				float d = Distance(points[y], points[x]);
+				if (d < dist[y]) {
+					dist[y] = d;
+					heap.push(std::make_pair(d, y));
+				}
+			}
+		}
+	}
+
+	/**
+		Helper function for the sparse Rips filtration: the first radius
+		alpha with d + w_p(alpha) + w_q(alpha) <= 2 alpha, for the weights of
+		insertion radii lp and lq. The left side grows slower than 2 alpha,
+		so the root is found on the linear piece between two breakpoints.
+	*/
+	inline double _SparseRipsEdgeRadius(double d, double lp, double lq, double epsilon) {
+		auto weight = [&](double l, double alpha) -> double {
+			if (alpha <= l / epsilon) return 0;
+			if (alpha < l / (epsilon * (1 - epsilon))) return alpha - l / epsilon;
+			return epsilon * alpha;
+		};
+		auto gap = [&](double alpha) {
+			return d + weight(lp, alpha) + weight(lq, alpha) - 2 * alpha;
+		};
+		const double infinity = std::numeric_limits<double>::infinity();
+		double breakpoint[4] = { lp / epsilon, lp / (epsilon * (1 - epsilon)), lq / epsilon, lq / (epsilon * (1 - epsilon)) };
+		std::sort(breakpoint, breakpoint + 4);
+		double lo = 0, gap_lo = gap(0);
+		if (gap_lo <= 0) return 0;
+		for (int i = 0; i < 4 && breakpoint[i] < infinity; i++) {
+			double hi = breakpoint[i];
+			if (hi <= lo) continue;
+			double gap_hi = gap(hi);
+			if (gap_hi <= 0) return lo + gap_lo * (hi - lo) / (gap_lo - gap_hi);
+			lo = hi;
+			gap_lo = gap_hi;
+		}
+		/// past the breakpoints a finite insertion radius weighs epsilon a, an infinite one 0
+		double slope = (lp < infinity ? epsilon : 0) + (lq < infinity ? epsilon : 0) - 2;
+		return lo - gap_lo / slope;
+	}
+
+	/**
+		Construct the sparse Rips filtration (Sheehy) up to max_epsilon, for
+		an approximation factor 0 < epsilon <= 1/3. With the insertion radii
+		l of the greedy permutation, a point gets the weight
+			w(a) = 0 up to l / epsilon, then a - l / epsilon up to
+			l / (epsilon (1 - epsilon)), then epsilon a,
+		an edge enters at the first radius a with d + w_p(a) + w_q(a) <= 2 a,
+		and a point leaves the net after radius l / (epsilon (1 - epsilon)).
+		A simplex enters at its longest edge if its points are still in the
+		net then, and never otherwise, which bounds the size linearly in n
+		for points of bounded doubling dimension. Values are diameters
+		2a, as in VRFilteredComplexConstruct, whose persistence diagram is
+		approximated within a factor 1 / (1 - 2 epsilon).
+	*/
+	template<typename PointType>
+	void SparseRipsFilteredComplexConstruct(
+		float max_epsilon,
+		const Array<PointType>& points,
+		float epsilon,
+		int k,
+		FilteredComplex<PointType>& complex
+	) {
+		if (epsilon <= 0 || epsilon > 1.0f / 3) throw "the approximation factor should be in (0, 1/3]";
+		int n = points.size();
+		Array<int> order;
+		Array<float> radius;
+		GreedyPermutation(points, order, radius);
+		Array<float> lambda(n), death(n);
+		Array<int> position(n);
+		for (int i = 0; i < n; i++) {
+			lambda[order[i]] = radius[i];
+			position[order[i]] = i;
+			/// as a diameter
+			death[order[i]] = 2 * radius[i] / (epsilon * (1 - epsilon));
+		}
+		PointKdTree<PointType> tree;
+		tree.Build(points);
+		/// an edge needs its later point in the net, so it is not longer than that point's death
+		Array<Array<std::pair<int, float>>> earlier(n);
+#pragma omp parallel for schedule(dynamic, 16)
+		for (int j = 0; j < n; j++) {
+			Array<int> near;
+			tree.Radius(points[j], myMin(death[j], max_epsilon), near);
+			for (int t = 0; t < near.size(); t++) {
+				int i = near[t];
+				if (position[i] >= position[j]) continue;
+				float d = Distance(points[i], points[j]);
+				float val = (float)(2 * _SparseRipsEdgeRadius(d, lambda[i], lambda[j], epsilon));
+				if (val <= max_epsilon && val <= death[j]) earlier[j].push_back(std::make_pair(i, val));
+			}
+		}
+		Array<std::pair<int, int>> edges;
+		Array<float> edge_value;
+		for (int j = 0; j < n; j++) {
+			for (int t = 0; t < earlier[j].size(); t++) {
+				edges.push_back(std::make_pair(earlier[j][t].first, j));
+				edge_value.push_back(earlier[j][t].second);
+			}
+		}
+		NeighborGraph graph;
+		graph.Build(n, edges, edge_value);
+		Array<Array<int>> results;
+		Array<float> values;
+		CliqueExpansion(graph, k, results, values);
+		complex.points = points;
+		for (int i = 0; i < results.size(); i++) {
+			float alive = FLT_MAX;
+			for (int l = 0; l < results[i].size(); l++) alive = myMin(alive, death[results[i][l]]);
+			if (values[i] > alive) continue;
+			complex.AddSimplex(results[i], values[i]);
+		}
+		complex.Sort();
+	}
+
+	/**
+		Construct the alpha complex filtration (Edelsbrunner) of the points,
+		using their first point_dim coordinates, all of them by default. The
+		Delaunay triangulation is computed in the affine hull of the points,
+		which should have at most 3 dimensions, so planar input in 3D gives a
+		2D complex. All the geometry is done on the coordinates in that hull.
+		From the top simplices down, a simplex
+		takes the diameter of its circumsphere, unless a coface has its
+		opposite vertex inside that circumsphere, then it takes the smallest
+		value of its cofaces. The values never exceed those of the cofaces.
+		The diameter is used so that an edge appears at its length, as in
+		the VR construction.
+	*/
+	template<typename PointType>
+	void AlphaComplexConstruct(
+		const Array<PointType>& points,
+		FilteredComplex<PointType>& complex,
+		int point_dim = PointType::dims
+	) {
+		if (point_dim < 1 || point_dim > PointType::dims) throw "point_dim should be in [1, PointType::dims]";
+		int n = points.size();
+		Array<double> coords(n * point_dim);
+		for (int i = 0; i < n; i++) {
+			for (int k = 0; k < point_dim; k++) coords[i * point_dim + k] = points[i][k];
+		}
+		/// orthonormal basis of the affine hull, by Gram-Schmidt
+		double extent = 0;
+		for (int i = 0; i < n * point_dim; i++) extent = myMax(extent, fabs(coords[i] - coords[i % point_dim]));
+		Array<Array<double>> basis;
+		Array<double> diff(point_dim);
+		for (int i = 1; i < n && basis.size() < point_dim; i++) {
+			for (int k = 0; k < point_dim; k++) diff[k] = coords[i * point_dim + k] - coords[k];
+			for (int b = 0; b < basis.size(); b++) {
+				double dot = 0;
+				for (int k = 0; k < point_dim; k++) dot += diff[k] * basis[b][k];
+				for (int k = 0; k < point_dim; k++) diff[k] -= dot * basis[b][k];
+			}
+			double norm = 0;
+			for (int k = 0; k < point_dim; k++) norm += diff[k] * diff[k];
+			norm = sqrt(norm);
+			if (norm <= 1e-6 * extent) continue;
+			for (int k = 0; k < point_dim; k++) diff[k] /= norm;
+			basis.push_back(diff);
+		}
+		int dim = basis.size();
+		if (dim > 3) throw "the alpha complex needs points spanning at most 3 dimensions";
+		Array<Array<int>> top;
+		Array<double> local(n * dim);
+		if (dim > 0) {
+			for (int i = 0; i < n; i++) {
+				for (int b = 0; b < dim; b++) {
+					double dot = 0;
+					for (int k = 0; k < point_dim; k++) dot += (coords[i * point_dim + k] - coords[k]) * basis[b][k];
+					local[i * dim + b] = dot;
+				}
+			}
+			DelaunayTriangulation(local, dim, top);
+		}
+
+		/// faces[m] are the simplices with m + 1 vertices, -1 for an unset value
+		Array<Array<Array<int>>> faces(dim + 1);
+		Array<Array<float>> values(dim + 1), upper(dim + 1);
+		Array<std::unordered_map<SimplexKey, int>> face_index(dim + 1);
+		Array<int> face;
+		for (int t = 0; t < top.size(); t++) {
+			for (int mask = 1; mask < (1 << (dim + 1)); mask++) {
+				face.clear();
+				for (int l = 0; l <= dim; l++) {
+					if (mask >> l & 1) face.push_back(top[t][l]);
+				}
+				int m = face.size() - 1;
+				if (m == 0) continue;
+				if (face_index[m].insert(std::pair<SimplexKey, int>(SimplexKey(face), faces[m].size())).second) {
+					faces[m].push_back(face);
+					values[m].push_back(-1);
+					upper[m].push_back(FLT_MAX);
+				}
+			}
+		}
+		Array<double> center(dim);
+		for (int m = dim; m > 0; m--) {
+			for (int i = 0; i < faces[m].size(); i++) {
+				const Array<int>& simplex = faces[m][i];
+				if (values[m][i] < 0) {
+					double radius2 = Circumsphere(get_ptr(local), get_ptr(simplex), m + 1, dim, get_ptr(center));
+					/// clamped by the cofaces, as rounding may break the order on slivers
+					values[m][i] = myMin(float(2 * sqrt(myMax(radius2, 0.0))), upper[m][i]);
+				}
+				if (m == 1) continue;
+				for (int k = 0; k <= m; k++) {
+					face.clear();
+					for (int l = 0; l <= m; l++) {
+						if (l != k) face.push_back(simplex[l]);
+					}
+					int f = face_index[m - 1].at(SimplexKey(face));
+					upper[m - 1][f] = myMin(upper[m - 1][f], values[m][i]);
+					if (values[m - 1][f] >= 0) {
+						values[m - 1][f] = myMin(values[m - 1][f], values[m][i]);
+						continue;
+					}
+					/// the face is not Gabriel: the opposite vertex is inside its circumsphere
+					double radius2 = Circumsphere(get_ptr(local), get_ptr(face), m, dim, get_ptr(center));
+					double dist2 = 0;
+					for (int d = 0; d < dim; d++) {
+						double offset = local[simplex[k] * dim + d] - center[d];
+						dist2 += offset * offset;
+					}
+					if (dist2 < radius2) values[m - 1][f] = upper[m - 1][f];
+				}
+			}
+		}
+		complex.points = points;
+		for (int i = 0; i < n; i++) {
+			complex.AddSimplex(Array<int>(1, i), 0);
+		}
+		for (int m = 1; m <= dim; m++) {
+			for (int i = 0; i < faces[m].size(); i++) {
+				complex.AddSimplex(faces[m][i], values[m][i]);
+			}
+		}
+		complex.Sort();
+	}
+
+	/**
+		Construct the lower-star filtration of a scalar function on a mesh:
+		cells are the triangles or tetrahedra as vertex indices, and every
+		face of the closure takes the largest value of its vertices. The
+		vertices not in any cell are kept. The faces come from
+		SimplicialClosure in lexicographic order within each dimension, so
+		one sort of (value, dim, index) keys gives the order of Sort()
+		without sorting the simplices themselves.
+	*/
+	template<typename PointType, typename ValueType>
+	void LowerStarConstruct(
+		const Array<PointType>& points,
+		const Array<Array<int>>& cells,
+		const Array<ValueType>& vertex_value,
+		FilteredComplex<PointType>& complex
+	) {
+		int n = vertex_value.size();
+		Array<Array<int>> maximal(cells);
+		for (int i = 0; i < n; i++) maximal.push_back(Array<int>(1, i));
+		Array<Array<int>> faces;
+		SimplicialClosure(maximal, faces);
+		if (faces.size() > 0 && faces[0].size() != n) throw "a cell has a vertex without a value";
+
+		/// (value, dim, index in faces[dim])
+		Array<std::tuple<float, int, int>> key;
+		for (int k = 0; k < faces.size(); k++) {
+			int face_num = faces[k].size() / (k + 1);
+			size_t start = key.size();
+			key.resize(start + face_num);
+#pragma omp parallel for
+			for (int f = 0; f < face_num; f++) {
+				ValueType face_value = vertex_value[faces[k][(size_t)f * (k + 1)]];
+				for (int l = 1; l <= k; l++) face_value = myMax(face_value, vertex_value[faces[k][(size_t)f * (k + 1) + l]]);
+				key[start + f] = std::make_tuple((float)face_value, k, f);
+			}
+		}
+		std::sort(key.begin(), key.end());
+		complex.points = points;
+		complex.simplex.resize(key.size());
+		complex.value.resize(key.size());
+#pragma omp parallel for
+		for (int i = 0; i < key.size(); i++) {
+			int k = std::get<1>(key[i]), f = std::get<2>(key[i]);
+			complex.simplex[i] = Simplex<int>(&faces[k][(size_t)f * (k + 1)], k + 1);
+			complex.simplex[i].simplex_index = i;
+			complex.value[i] = std::get<0>(key[i]);
+		}
+	}
+
+	/**
+		Construct the VR filtration up to max_epsilon as a simplex tree,
+		edge_collapse as VRFilteredComplexConstruct
+	*/
+	template<typename PointType>
+	void VRSimplexTreeConstruct(
+		float max_epsilon,
+		const Array<PointType>& points,
+		int k,
+		SimplexTree<PointType>& complex,
+		bool edge_collapse = false
+	) {
+		NeighborGraph graph;
+		NeighborGraphConstruct(max_epsilon, points, graph);
+		if (edge_collapse) {
+			NeighborGraph collapsed;
+			EdgeCollapse(graph, collapsed);
+			graph = collapsed;
+		}
+		Array<Array<int>> results;
+		Array<float> values;
+		CliqueExpansion(graph, k, results, values);
+		complex.points = points;
+		/// the cliques are sorted, each after its prefix, and they are all there
+		for (int i = 0; i < results.size(); i++) {
+			complex.InsertPath(results[i], values[i]);
+		}
+	}
 
 	void FindWitness(
 		const Array<int>& index,
@@ -901,6 +3474,92 @@ namespace zq{
 		//printf("results.size():%d\n", results.size());
 	}
 
+	/**
+		Build the witnessed graph of the landmarks witness_index: every point
+		finds its landmarks within epsilon once (only the max_landmarks nearest
+		ones if max_landmarks > 0), and every pair of them is a witnessed edge.
+		The vertices of graph are the positions in witness_index, the weight
+		of an edge is the smallest radius at which it is witnessed.
+	*/
+	template<typename ParaType, typename PointType>
+	void WitnessGraphConstruct(
+		const ParaType& epsilon,
+		const Array<PointType>& points,
+		const Array<int>& witness_index,
+		NeighborGraph& graph,
+		int max_landmarks = -1
+	) {
+		int n = points.size();
+		int w = witness_index.size();
+		Array<Array<std::pair<long long, float>>> local_edges(n);
+#pragma omp parallel for schedule(dynamic, 16)
+		for (int p = 0; p < n; p++) {
+			Array<std::pair<float, int>> near_landmarks;
+			for (int l = 0; l < w; l++) {
+				float dist = Distance(points[witness_index[l]], points[p]);
+				if (dist <= epsilon) near_landmarks.push_back(std::pair<float, int>(dist, l));
+			}
+			if (max_landmarks > 0 && near_landmarks.size() > max_landmarks) {
+				std::nth_element(near_landmarks.begin(), near_landmarks.begin() + max_landmarks, near_landmarks.end());
+				near_landmarks.resize(max_landmarks);
+			}
+			for (int i = 0; i < near_landmarks.size(); i++) {
+				for (int j = i + 1; j < near_landmarks.size(); j++) {
+					int a = myMin(near_landmarks[i].second, near_landmarks[j].second);
+					int b = myMax(near_landmarks[i].second, near_landmarks[j].second);
+					float radius = myMax(near_landmarks[i].first, near_landmarks[j].first);
+					local_edges[p].push_back(std::pair<long long, float>((long long)a * w + b, radius));
+				}
+			}
+		}
+		Array<std::pair<long long, float>> all_edges;
+		for (int p = 0; p < n; p++) {
+			all_edges.insert(all_edges.end(), local_edges[p].begin(), local_edges[p].end());
+			Array<std::pair<long long, float>>().swap(local_edges[p]);
+		}
+		/// the same edge is witnessed by many points, keep the smallest radius
+		std::sort(all_edges.begin(), all_edges.end());
+		Array<std::pair<int, int>> edges;
+		Array<float> edge_weight;
+		for (int i = 0; i < all_edges.size(); i++) {
+			if (i > 0 && all_edges[i].first == all_edges[i - 1].first) continue;
+			edges.push_back(std::pair<int, int>(all_edges[i].first / w, all_edges[i].first % w));
+			edge_weight.push_back(all_edges[i].second);
+		}
+		graph.Build(w, edges, edge_weight);
+	}
+
+	/**
+		Construct the same witness complex as VRWitnessComplexConstruct, but
+		emit the witnessed edges directly and expand the cliques of the graph
+	*/
+	template<typename ParaType, typename PointType>
+	void VRWitnessComplexConstructByClique(
+		const ParaType& epsilon,
+		const Array<PointType>& points,
+		const Array<int>& witness_index,
+		int k,
+		Array<Array<int>>& results,
+		int max_landmarks = -1
+	) {
+		NeighborGraph graph;
+		WitnessGraphConstruct(epsilon, points, witness_index, graph, max_landmarks);
+		Array<Array<int>> cliques;
+		Array<float> values;
+		CliqueExpansion(graph, k, cliques, values);
+		std::sort(cliques.begin(), cliques.end(), [](const Array<int>& a, const Array<int>& b) {
+			if (a.size() != b.size()) return a.size() < b.size();
+			return a < b;
+		});
+		results.reserve(results.size() + cliques.size());
+		for (int i = 0; i < cliques.size(); i++) {
+			for (int j = 0; j < cliques[i].size(); j++) {
+				cliques[i][j] = witness_index[cliques[i][j]];
+			}
+			results.push_back(std::move(cliques[i]));
+		}
+	}
+
 	/**
 		Find the epsilon intervals
 	*/
@@ -913,9 +3572,8 @@ namespace zq{
 		Array<int>& feture_type
 	) {
 		Simplical_Complex<Type>::AssignSimplexIndexSort<Type>(complex_list);
-		DenseMatrix<int> memory_m;
 		int final_index = complex_list.size() - 1;
-		DenseMatrix<int> boundary_m = complex_list[final_index].ReducedBoundaryMatrix(memory_m);
+		DenseMatrix<int> boundary_m = complex_list[final_index].ReducedBoundaryMatrix();
 
 		//std::cout << "boundary_m:" << std::endl;
 		//std::cout << boundary_m << std::endl;
@@ -952,22 +3610,22 @@ namespace zq{
 		float max_epsilon,
 		Array<Simplical_Complex<Type>>& complex_list,
 		Array<std::pair<float, float>>& epsilon_interval,
-		Array<int>& feture_type
+		Array<int>& feture_type,
+		ReductionType type = ReductionType::TWIST
 	) {
 		//printf("begin\n");
 		Simplical_Complex<Type>::AssignSimplexIndexSort<Type>(complex_list);
 		printf("end assign index\n");
-		SparseMatrixLIL<int> memory_m;
 		int final_index = complex_list.size() - 1;
-		SparseMatrixLIL<int> boundary_m = complex_list[final_index].ReducedBoundaryMatrixSparse(memory_m);
+		Z2BoundaryMatrix<> boundary_m = complex_list[final_index].BoundaryMatrixZ2();
 		printf("end get matrix\n");
 
 		//std::cout << "boundary_m:" << std::endl;
 		//std::cout << boundary_m << std::endl;
 
 		Array<std::pair<int, int>> interval;
-		Simplical_Complex<Type>::ReadIntervals(boundary_m, interval);
-		if (!Simplical_Complex<Type>::CheckReduced(boundary_m)) {
+		Simplical_Complex<Type>::PersistenceIntervals(boundary_m, interval, type);
+		if (type != ReductionType::COHOMOLOGY && !Simplical_Complex<Type>::CheckReduced(boundary_m)) {
 			throw "bouandry_m is not redueced";
 		}
 
@@ -991,6 +3649,428 @@ namespace zq{
 			epsilon_interval.push_back(std::pair<float, float>(start_epsilon, end_epsilon));
 		}
 	}
+
+	/**
+		Find the epsilon intervals of a filtered complex, the birth and death
+		are the exact filtration values of the paired simplices
+	*/
+	template<typename Type>
+	void CalculatePersistentDataSparse(
+		float max_epsilon,
+		const FilteredComplex<Type>& complex,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type,
+		ReductionType type = ReductionType::TWIST,
+		bool morse_reduction = false
+	) {
+		Array<std::pair<int, int>> interval;
+		complex.PersistencePairs(interval, type, morse_reduction);
+		for (int i = 0; i < interval.size(); i++) {
+			feture_type.push_back(complex.simplex[interval[i].first].Dim());
+			float start_epsilon = complex.value[interval[i].first];
+			float end_epsilon = max_epsilon;
+			if (interval[i].second != -1) {
+				end_epsilon = complex.value[interval[i].second];
+			}
+			epsilon_interval.push_back(std::pair<float, float>(start_epsilon, end_epsilon));
+		}
+	}
+
+	/**
+		Find the epsilon intervals of a simplex tree
+	*/
+	template<typename Type>
+	void CalculatePersistentDataSparse(
+		float max_epsilon,
+		const SimplexTree<Type>& complex,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type,
+		ReductionType type = ReductionType::TWIST,
+		bool morse_reduction = false
+	) {
+		Array<std::pair<int, int>> interval;
+		Array<int> order;
+		complex.PersistencePairs(interval, order, type, morse_reduction);
+		for (int i = 0; i < interval.size(); i++) {
+			feture_type.push_back(complex.NodeDim(order[interval[i].first]));
+			float start_epsilon = complex.Value(order[interval[i].first]);
+			float end_epsilon = max_epsilon;
+			if (interval[i].second != -1) {
+				end_epsilon = complex.Value(order[interval[i].second]);
+			}
+			epsilon_interval.push_back(std::pair<float, float>(start_epsilon, end_epsilon));
+		}
+	}
+
+	/**
+		Disjoint sets with path compression and union by rank
+	*/
+	class UnionFind {
+	public:
+		Array<int> parent;
+		Array<int> rank;
+	public:
+		UnionFind(int n = 0) {
+			Init(n);
+		}
+		void Init(int n) {
+			parent.resize(n);
+			rank.assign(n, 0);
+			for (int i = 0; i < n; i++) parent[i] = i;
+		}
+		int Find(int i) {
+			int root = i;
+			while (parent[root] != root) root = parent[root];
+			while (parent[i] != root) {
+				int next = parent[i];
+				parent[i] = root;
+				i = next;
+			}
+			return root;
+		}
+		/**
+			merge the sets of the roots a and b, return the new root
+		*/
+		int Union(int a, int b) {
+			if (rank[a] < rank[b]) std::swap(a, b);
+			parent[b] = a;
+			if (rank[a] == rank[b]) rank[a]++;
+			return a;
+		}
+	};
+
+	/**
+		Helper function for the H0 intervals: merge the components along the
+		edges in filtration order (Kruskal). When two components meet, the
+		younger one dies at the edge (elder rule). birth is the value of
+		each vertex.
+	*/
+	inline void _PersistenceH0(
+		const Array<float>& birth,
+		const Array<std::pair<int, int>>& edges,
+		const Array<float>& edge_value,
+		float max_epsilon,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type
+	) {
+		int n = birth.size();
+		UnionFind sets(n);
+		Array<float> oldest = birth;	/// smallest birth of the component, kept at the root
+		for (int i = 0; i < edges.size(); i++) {
+			int a = sets.Find(edges[i].first);
+			int b = sets.Find(edges[i].second);
+			if (a == b) continue;
+			epsilon_interval.push_back(std::pair<float, float>(myMax(oldest[a], oldest[b]), edge_value[i]));
+			feture_type.push_back(1);
+			float born = myMin(oldest[a], oldest[b]);
+			oldest[sets.Union(a, b)] = born;
+		}
+		for (int i = 0; i < n; i++) {
+			if (sets.Find(i) != i) continue;
+			epsilon_interval.push_back(std::pair<float, float>(oldest[i], max_epsilon));
+			feture_type.push_back(1);
+		}
+	}
+
+	/**
+		Find the H0 intervals of the Rips filtration of a neighbor graph by
+		union-find, without building the complex. All the vertices are born
+		at 0, feture_type is 1 as for the vertices in
+		CalculatePersistentDataSparse.
+	*/
+	inline void CalculatePersistentDataH0(
+		float max_epsilon,
+		const NeighborGraph& graph,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type
+	) {
+		int n = graph.VertexNumber();
+		Array<std::pair<int, int>> edges;
+		Array<float> edge_value;
+		for (int u = 0; u < n; u++) {
+			const int* nbr = graph.Neighbors(u);
+			for (int k = 0; k < graph.Degree(u); k++) {
+				if (nbr[k] > u) {
+					edges.push_back(std::pair<int, int>(u, nbr[k]));
+					edge_value.push_back(graph.weight[graph.offset[u] + k]);
+				}
+			}
+		}
+		Array<int> order(edges.size());
+		for (int i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](int a, int b) {return edge_value[a] < edge_value[b]; });
+		Array<std::pair<int, int>> sorted_edges(edges.size());
+		Array<float> sorted_value(edges.size());
+		for (int i = 0; i < order.size(); i++) {
+			sorted_edges[i] = edges[order[i]];
+			sorted_value[i] = edge_value[order[i]];
+		}
+		_PersistenceH0(Array<float>(n, 0), sorted_edges, sorted_value, max_epsilon, epsilon_interval, feture_type);
+	}
+
+	/**
+		H0 intervals of the Rips filtration of the points up to max_epsilon
+	*/
+	template<typename PointType>
+	void CalculatePersistentDataH0(
+		float max_epsilon,
+		const Array<PointType>& points,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type
+	) {
+		NeighborGraph graph;
+		NeighborGraphConstruct(max_epsilon, points, graph);
+		CalculatePersistentDataH0(max_epsilon, graph, epsilon_interval, feture_type);
+	}
+
+	/**
+		H0 intervals of a filtered complex from its vertices and edges only.
+		Sort() should be called first.
+	*/
+	template<typename Type>
+	void CalculatePersistentDataH0(
+		float max_epsilon,
+		const FilteredComplex<Type>& complex,
+		Array<std::pair<float, float>>& epsilon_interval,
+		Array<int>& feture_type
+	) {
+		/// the vertices are numbered in filtration order, a point index
+		/// missing from the complex is not a component
+		Array<int> vertex_index;
+		Array<float> birth;
+		Array<std::pair<int, int>> edges;
+		Array<float> edge_value;
+		for (int i = 0; i < complex.SimplexNumber(); i++) {
+			const Simplex<int>& simplex = complex.simplex[i];
+			if (simplex.Dim() == 1) {
+				int v = simplex.points[0];
+				if (v >= vertex_index.size()) vertex_index.resize(v + 1, -1);
+				vertex_index[v] = birth.size();
+				birth.push_back(complex.value[i]);
+			}
+			else if (simplex.Dim() == 2) {
+				edges.push_back(std::pair<int, int>(vertex_index[simplex.points[0]], vertex_index[simplex.points[1]]));
+				edge_value.push_back(complex.value[i]);
+			}
+		}
+		_PersistenceH0(birth, edges, edge_value, max_epsilon, epsilon_interval, feture_type);
+	}
+
+	/**
+		Vineyard (Cohen-Steiner, Edelsbrunner and Morozov): persistence of a
+		fixed complex whose filtration values change. The decomposition
+		R = DV is kept, and a new order is reached by swapping adjacent
+		simplices, each swap patching R and V with a few column additions,
+		so an update costs the number of swaps instead of a full reduction.
+		The columns of R and V are stored per simplex as sorted simplex
+		ids, so swapping two rows only changes position.
+	*/
+	class Vineyard {
+	public:
+		Array<Array<int>> boundary;	/// facets of each simplex
+		Array<int> dims;			/// number of vertices of each simplex
+		Array<float> value;
+		Array<int> order;			/// position -> simplex
+		Array<int> position;		/// simplex -> position
+		Array<Array<int>> r;
+		Array<Array<int>> v;
+		Array<int> pivot;			/// simplex -> column whose low is it, -1 if none
+	public:
+		/**
+			Start from a sorted filtered complex, simplex i of the complex
+			is simplex i of the vineyard. The matrix is reduced once with V.
+		*/
+		template<typename T>
+		void Init(const FilteredComplex<T>& complex) {
+			if (!Simplical_Complex<T>::FacetIndex(complex.simplex, complex.simplex, boundary)) {
+				throw "the complex is not closed under faces";
+			}
+			int n = complex.SimplexNumber();
+			dims.resize(n);
+			for (int i = 0; i < n; i++) dims[i] = complex.simplex[i].Dim();
+			value = complex.value;
+			order.resize(n);
+			position.resize(n);
+			for (int i = 0; i < n; i++) order[i] = position[i] = i;
+			r = boundary;
+			v.resize(n);
+			pivot.assign(n, -1);
+			for (int i = 0; i < n; i++) {
+				v[i].assign(1, i);
+				int low_i = Low(i);
+				while (low_i != -1 && pivot[low_i] != -1) {
+					AddColumn(pivot[low_i], i);
+					low_i = Low(i);
+				}
+				if (low_i != -1) pivot[low_i] = i;
+			}
+		}
+
+		int SimplexNumber() const {
+			return order.size();
+		}
+
+		/**
+			the simplex of the lowest nonzero row of column id, -1 if zero
+		*/
+		int Low(int id) const {
+			int low = -1;
+			for (int k = 0; k < r[id].size(); k++) {
+				if (low == -1 || position[r[id][k]] > position[low]) low = r[id][k];
+			}
+			return low;
+		}
+
+		/**
+			Swap the simplices at position i and i + 1, the first one should
+			not be a facet of the second
+		*/
+		void Transpose(int i) {
+			int a = order[i], b = order[i + 1];
+			if (dims[a] != dims[b]) {
+				/// no column combines the two, and no column has both rows, the pairs stay
+				if (std::binary_search(boundary[b].begin(), boundary[b].end(), a)) {
+					throw "the swap breaks the order of a face and its coface";
+				}
+				_Swap(i);
+				return;
+			}
+			/// the columns whose low may move: the swapped ones and those paired to their rows
+			int affected[4] = { a, b, pivot[a], pivot[b] };
+			for (int k = 0; k < 4; k++) {
+				if (affected[k] == -1) continue;
+				int low = Low(affected[k]);
+				if (low != -1 && pivot[low] == affected[k]) pivot[low] = -1;
+			}
+			bool positive_a = r[a].empty(), positive_b = r[b].empty();
+			bool v_ab = std::binary_search(v[b].begin(), v[b].end(), a);
+			if (positive_a && positive_b) {
+				if (v_ab) _AddSorted(v[a], v[b]);
+				int k = affected[2], l = affected[3];
+				_Swap(i);
+				/// both lows fall on the row of a after the swap, the earlier column is added to the later
+				if (k != -1 && l != -1 && std::binary_search(r[l].begin(), r[l].end(), a)) {
+					if (position[k] < position[l]) AddColumn(k, l);
+					else AddColumn(l, k);
+				}
+			}
+			else if (!positive_a && !positive_b) {
+				if (v_ab) {
+					bool switch_pair = position[Low(a)] > position[Low(b)];
+					AddColumn(a, b);
+					_Swap(i);
+					if (switch_pair) AddColumn(b, a);
+				}
+				else _Swap(i);
+			}
+			else if (!positive_a && positive_b) {
+				if (v_ab) {
+					AddColumn(a, b);
+					_Swap(i);
+					AddColumn(b, a);
+				}
+				else _Swap(i);
+			}
+			else {
+				/// column a of R is zero, so only V changes
+				if (v_ab) _AddSorted(v[a], v[b]);
+				_Swap(i);
+			}
+			for (int k = 0; k < 4; k++) {
+				if (affected[k] == -1) continue;
+				int low = Low(affected[k]);
+				if (low != -1) pivot[low] = affected[k];
+			}
+		}
+
+		/**
+			Set the new filtration values of the simplices and reach their
+			order by adjacent swaps, the values should be monotone on the
+			faces. Return the number of swaps.
+		*/
+		int Update(const Array<float>& new_value) {
+			int n = order.size();
+			value = new_value;
+			Array<int> target(order);
+			std::stable_sort(target.begin(), target.end(), [&](int x, int y) {
+				if (value[x] != value[y]) return value[x] < value[y];
+				return dims[x] < dims[y];
+			});
+			Array<int> rank(n);
+			for (int i = 0; i < n; i++) rank[target[i]] = i;
+			int swap_num = 0;
+			for (int i = 1; i < n; i++) {
+				for (int j = i; j > 0 && rank[order[j - 1]] > rank[order[j]]; j--) {
+					Transpose(j - 1);
+					swap_num++;
+				}
+			}
+			return swap_num;
+		}
+
+		/**
+			Intervals in the form of CalculatePersistentDataSparse
+		*/
+		void Intervals(
+			float max_epsilon,
+			Array<std::pair<float, float>>& epsilon_interval,
+			Array<int>& feture_type
+		) const {
+			for (int i = 0; i < order.size(); i++) {
+				int id = order[i];
+				if (!r[id].empty()) continue;
+				feture_type.push_back(dims[id]);
+				float end_epsilon = pivot[id] == -1 ? max_epsilon : value[pivot[id]];
+				epsilon_interval.push_back(std::pair<float, float>(value[id], end_epsilon));
+			}
+		}
+
+		/**
+			add column source to column target in R and V
+		*/
+		void AddColumn(int source, int target) {
+			_AddSorted(r[source], r[target]);
+			_AddSorted(v[source], v[target]);
+		}
+
+	protected:
+		void _Swap(int i) {
+			std::swap(order[i], order[i + 1]);
+			position[order[i]] = i;
+			position[order[i + 1]] = i + 1;
+		}
+		static void _AddSorted(const Array<int>& source, Array<int>& target) {
+			Array<int> result;
+			result.reserve(source.size() + target.size());
+			std::set_symmetric_difference(source.begin(), source.end(), target.begin(), target.end(), std::back_inserter(result));
+			target.swap(result);
+		}
+	};
+
+	/**
+		Recompute the VR values of the simplices of complex for moved
+		points, value of simplex i is the largest distance between its
+		vertices, as Vineyard::Update takes. The complex is not rebuilt, so
+		the filtration is exact only below the length of the shortest edge
+		missing from it, build it with some margin on max_epsilon.
+	*/
+	template<typename PointType>
+	void VRFiltrationValues(
+		const Array<PointType>& points,
+		const FilteredComplex<PointType>& complex,
+		Array<float>& values
+	) {
+		values.assign(complex.SimplexNumber(), 0);
+#pragma omp parallel for
+		for (int i = 0; i < complex.SimplexNumber(); i++) {
+			const Array<int>& vertices = complex.simplex[i].points;
+			for (int j = 0; j < vertices.size(); j++) {
+				for (int k = j + 1; k < vertices.size(); k++) {
+					values[i] = myMax(values[i], Distance(points[vertices[j]], points[vertices[k]]));
+				}
+			}
+		}
+	}
 }	
 
 #endif	//	__MATH_HOMOLOGY_H__
\ No newline at end of file
@@ -202,29 +202,19 @@ namespace zq {
 				Simplical_Complex<Vec<T, d>>& complex
 			) {
 				complex.points = center;
-				std::unordered_set<Simplex<int>> simplex_set;
+				/// the nerve is the closure of the vertices and the cluster overlaps
+				Array<Array<int>> maximal;
 				for (int i = 0; i < center.size(); i++) {
-					complex.simplex.push_back(Simplex<int>(std::vector<int>{i}));
-					simplex_set.insert(Simplex<int>(std::vector<int>{i}));
+					maximal.push_back(Array<int>(1, i));
 				}
 				for (int i = 0; i < clusters_map_num.size(); i++) {
-					if constexpr (Filter::res_dim == 1) {
-						if (clusters_map_num[i] == 2) {
-							complex.AddSimplex(Simplex<int>(std::vector<int>{clusters_map[0][i], clusters_map[1][i]}), simplex_set);
-						}
-					}
-					else if constexpr (Filter::res_dim == 2) {
-						if (clusters_map_num[i] == 2) {
-							complex.AddSimplex(Simplex<int>(std::vector<int>{clusters_map[0][i], clusters_map[1][i]}), simplex_set);
-						}
-						else if (clusters_map_num[i] == 3) {
-							complex.AddSimplex(Simplex<int>(std::vector<int>{clusters_map[0][i], clusters_map[1][i], clusters_map[2][i]}), simplex_set);
-						}
-						else if (clusters_map_num[i] == 4) {
-							complex.AddSimplex(Simplex<int>(std::vector<int>{clusters_map[0][i], clusters_map[1][i], clusters_map[2][i], clusters_map[3][i]}), simplex_set);
-						}
-					}
+					int num = clusters_map_num[i];
+					if (num < 2 || num > (Filter::res_dim == 1 ? 2 : 4)) continue;
+					Array<int> simplex(num);
+					for (int k = 0; k < num; k++) simplex[k] = clusters_map[k][i];
+					maximal.push_back(simplex);
 				}
+				complex.AddClosure(maximal);
 			}
 			template<class T,int d, int side>
 			void DoMapper(
@@ -0,0 +1,787 @@
+/***********************************************************/
+/**	\file
+	\brief		persistence diagrams
+	\details	distances and vectorizations of persistence diagrams, in the form of the
+				epsilon_interval output of math_homology.h
+	\author		Zhiqi Li
+	\date	    10/17/2026
+
+*/
+/***********************************************************/
+#ifndef __MATH_PERSISTENCE_DIAGRAM_H__
+#define __MATH_PERSISTENCE_DIAGRAM_H__
+
+#include <assert.h>
+#include <iostream>
+#include <math.h>
+#include <string.h>
+#include <limits>
+#include <algorithm>
+#include <set>
+#include <zqBasicMath/math_utils.h>
+#include <zqBasicUtils/utils_array.h>
+namespace zq {
+
+	/**
+		A persistence diagram is an Array<std::pair<float, float>> of
+		(birth, death). Points with death <= birth lie on the diagonal and are
+		ignored, points with an infinite death are essential and are only
+		matched with essential points of the other diagram. The intervals of
+		math_homology.h close the essential classes at max_epsilon, set their
+		death to infinity before the comparison to treat them as essential.
+
+		The ground metric is L-infinity, so the distance of a point to the
+		diagonal is (death - birth) / 2.
+	*/
+	enum DiagramDistanceType {
+		BOTTLENECK,
+		WASSERSTEIN
+	};
+
+	/**
+		2d kd-tree for the geometric matching, the points can be removed and
+		the queries only return the points left
+	*/
+	class DiagramKdTree {
+	public:
+		Array<float> x, y;
+		Array<int> perm;		/// the points in tree order, node i is perm[i] and covers [lo, hi) around it
+		Array<int> position;	/// point -> index in perm
+		Array<int> count;		/// points left in the range of the node
+		Array<float> box;		/// 4 floats per node: min x, max x, min y, max y of its range
+
+		void Init(const Array<float>& px, const Array<float>& py) {
+			x = px;
+			y = py;
+			int n = x.size();
+			perm.resize(n);
+			position.resize(n);
+			count.resize(n);
+			box.resize(4 * n);
+			for (int i = 0; i < n; i++) perm[i] = i;
+			_Build(0, n, 0);
+			for (int i = 0; i < n; i++) position[perm[i]] = i;
+		}
+
+		void Remove(int id) {
+			int lo = 0, hi = perm.size(), target = position[id];
+			while (lo < hi) {
+				int mid = (lo + hi) / 2;
+				count[mid]--;
+				if (target == mid) return;
+				if (target < mid) hi = mid;
+				else lo = mid + 1;
+			}
+		}
+
+		/**
+			any point left within L-infinity distance r of (qx, qy), -1 if none
+		*/
+		int FindOne(float qx, float qy, float r) const {
+			return _FindOne(0, perm.size(), qx, qy, r);
+		}
+
+	protected:
+		void _Build(int lo, int hi, int axis) {
+			if (lo >= hi) return;
+			int mid = (lo + hi) / 2;
+			const Array<float>& c = axis == 0 ? x : y;
+			std::nth_element(perm.begin() + lo, perm.begin() + mid, perm.begin() + hi,
+				[&](int a, int b) { return c[a] < c[b]; });
+			float* b = &box[4 * mid];
+			b[0] = b[2] = std::numeric_limits<float>::infinity();
+			b[1] = b[3] = -std::numeric_limits<float>::infinity();
+			for (int i = lo; i < hi; i++) {
+				b[0] = myMin(b[0], x[perm[i]]);
+				b[1] = myMax(b[1], x[perm[i]]);
+				b[2] = myMin(b[2], y[perm[i]]);
+				b[3] = myMax(b[3], y[perm[i]]);
+			}
+			count[mid] = hi - lo;
+			_Build(lo, mid, 1 - axis);
+			_Build(mid + 1, hi, 1 - axis);
+		}
+
+		int _FindOne(int lo, int hi, float qx, float qy, float r) const {
+			if (lo >= hi) return -1;
+			int mid = (lo + hi) / 2;
+			const float* b = &box[4 * mid];
+			if (count[mid] == 0 || b[0] - qx > r || qx - b[1] > r || b[2] - qy > r || qy - b[3] > r) return -1;
+			int p = perm[mid];
+			/// the node point is left if its count exceeds those of the children
+			int left = lo < mid ? count[(lo + mid) / 2] : 0;
+			int right = mid + 1 < hi ? count[(mid + 1 + hi) / 2] : 0;
+			if (count[mid] > left + right && fabs(x[p] - qx) <= r && fabs(y[p] - qy) <= r) return p;
+			int found = _FindOne(lo, mid, qx, qy, r);
+			if (found != -1) return found;
+			return _FindOne(mid + 1, hi, qx, qy, r);
+		}
+	};
+
+	/**
+		Split a diagram into the points off the diagonal and the births of
+		the essential points
+	*/
+	inline void _SplitDiagram(const Array<std::pair<float, float>>& diagram,
+		Array<std::pair<float, float>>& finite, Array<float>& essential) {
+		finite.clear();
+		essential.clear();
+		for (int i = 0; i < diagram.size(); i++) {
+			if (diagram[i].second == std::numeric_limits<float>::infinity()) essential.push_back(diagram[i].first);
+			else if (diagram[i].second > diagram[i].first) finite.push_back(diagram[i]);
+		}
+		std::sort(essential.begin(), essential.end());
+	}
+
+	/**
+		L-infinity distance of a point to its projection on the diagonal
+	*/
+	inline float _DiagonalDistance(const std::pair<float, float>& point) {
+		float m = 0.5f * (point.first + point.second);
+		return myMax(fabs(point.first - m), fabs(point.second - m));
+	}
+
+	/**
+		Geometric bipartite matching at threshold r (Efrat, Itai and Katz):
+		Hopcroft-Karp whose neighbor searches are kd-tree queries, a right
+		vertex is removed from the tree once it is visited in a phase.
+		The left side is the points of a and the projections of b, the right
+		side the points of b and the projections of a. Two projections are
+		always neighbors, a point and a projection are neighbors within L-infinity
+		distance r, which is only possible if the point is within r of the diagonal.
+	*/
+	class DiagramMatching {
+	public:
+		int na, nb, n;
+		Array<float> lx, ly, rx, ry;	/// the vertices, a projection lies on the diagonal
+		Array<int> mate_l, mate_r;
+		Array<int> layer_l;
+		int matched;
+		float r;
+
+		void Init(const Array<std::pair<float, float>>& a, const Array<std::pair<float, float>>& b) {
+			na = a.size();
+			nb = b.size();
+			n = na + nb;
+			mate_l.clear();
+			mate_r.clear();
+			lx.resize(n);
+			ly.resize(n);
+			rx.resize(n);
+			ry.resize(n);
+			for (int i = 0; i < na; i++) {
+				float m = 0.5f * (a[i].first + a[i].second);
+				lx[i] = a[i].first;
+				ly[i] = a[i].second;
+				rx[nb + i] = m;
+				ry[nb + i] = m;
+			}
+			for (int j = 0; j < nb; j++) {
+				float m = 0.5f * (b[j].first + b[j].second);
+				rx[j] = b[j].first;
+				ry[j] = b[j].second;
+				lx[na + j] = m;
+				ly[na + j] = m;
+			}
+		}
+
+		/**
+			Whether a perfect matching exists at the threshold. The matching is
+			kept between the calls, the edges longer than a smaller threshold
+			are dropped, so a binary search only augments the difference.
+		*/
+		bool Perfect(float threshold) {
+			r = threshold;
+			if (mate_l.size() != n) {
+				mate_l.assign(n, -1);
+				mate_r.assign(n, -1);
+				matched = 0;
+			}
+			for (int u = 0; u < n; u++) {
+				int v = mate_l[u];
+				if (v != -1 && Distance(u, v) > r) {
+					mate_l[u] = -1;
+					mate_r[v] = -1;
+					matched--;
+				}
+			}
+			while (matched < n) {
+				int augmented = _Phase();
+				if (augmented == 0) break;
+				matched += augmented;
+			}
+			return matched == n;
+		}
+
+		float Distance(int u, int v) const {
+			if (u >= na && v >= nb) return 0;
+			return myMax(fabs(lx[u] - rx[v]), fabs(ly[u] - ry[v]));
+		}
+
+	protected:
+		Array<DiagramKdTree> trees;				/// the right vertices of each layer
+		Array<Array<int>> diagonal;				/// the projections of each layer, neighbors of every left projection
+		Array<int> diagonal_cursor;
+		Array<Array<int>> layer_ids;			/// index in the tree of layer k -> right vertex
+		Array<int> local_id;					/// right vertex -> index in the tree of its layer
+		Array<int> layer_r;						/// -2 once visited by the DFS
+
+		/// take a neighbor of left vertex u from the right vertices of layer k, removing it
+		int _Take(int u, int k) {
+			int v = -1;
+			if (u >= na) {
+				Array<int>& d = diagonal[k];
+				while (diagonal_cursor[k] < d.size() && layer_r[d[diagonal_cursor[k]]] == -2) diagonal_cursor[k]++;
+				if (diagonal_cursor[k] < d.size()) v = d[diagonal_cursor[k]];
+			}
+			if (v == -1) {
+				int local = trees[k].FindOne(lx[u], ly[u], r);
+				if (local != -1) v = layer_ids[k][local];
+			}
+			if (v != -1) {
+				trees[k].Remove(local_id[v]);
+				layer_r[v] = -2;
+			}
+			return v;
+		}
+
+		void _BuildLayer(int k, const Array<int>& ids) {
+			Array<float> px(ids.size()), py(ids.size());
+			layer_ids[k] = ids;
+			diagonal[k].clear();
+			for (int i = 0; i < ids.size(); i++) {
+				px[i] = rx[ids[i]];
+				py[i] = ry[ids[i]];
+				local_id[ids[i]] = i;
+				if (ids[i] >= nb) diagonal[k].push_back(ids[i]);
+			}
+			trees[k].Init(px, py);
+			diagonal_cursor[k] = 0;
+		}
+
+		int _Phase() {
+			layer_l.assign(n, -1);
+			layer_r.assign(n, -1);
+			local_id.assign(n, -1);
+			trees.clear();
+			diagonal.clear();
+			diagonal_cursor.clear();
+			layer_ids.clear();
+			Array<int> front;
+			for (int u = 0; u < n; u++) {
+				if (mate_l[u] != -1) continue;
+				front.push_back(u);
+				layer_l[u] = 0;
+			}
+			if (front.empty()) return 0;
+
+			/// BFS with a tree of the right vertices not reached yet
+			DiagramKdTree unreached;
+			unreached.Init(rx, ry);
+			Array<int> unreached_diagonal;
+			for (int v = nb; v < n; v++) unreached_diagonal.push_back(v);
+			int diagonal_pos = 0;
+			bool found_free = false;
+			int k = 0;
+			while (!front.empty() && !found_free) {
+				Array<int> reached, next;
+				for (int i = 0; i < front.size(); i++) {
+					int u = front[i];
+					while (true) {
+						int v = -1;
+						if (u >= na) {
+							while (diagonal_pos < unreached_diagonal.size() && layer_r[unreached_diagonal[diagonal_pos]] != -1) diagonal_pos++;
+							if (diagonal_pos < unreached_diagonal.size()) v = unreached_diagonal[diagonal_pos];
+						}
+						if (v == -1) {
+							v = unreached.FindOne(lx[u], ly[u], r);
+							if (v == -1) break;
+						}
+						unreached.Remove(v);
+						layer_r[v] = k;
+						reached.push_back(v);
+						if (mate_r[v] == -1) found_free = true;
+						else {
+							layer_l[mate_r[v]] = k + 1;
+							next.push_back(mate_r[v]);
+						}
+					}
+				}
+				layer_ids.resize(k + 1);
+				trees.resize(k + 1);
+				diagonal.resize(k + 1);
+				diagonal_cursor.resize(k + 1);
+				_BuildLayer(k, reached);
+				front = next;
+				k++;
+			}
+			if (!found_free) return 0;
+			int last = k - 1;
+
+			/// DFS along the layers, each right vertex is taken once
+			int augmented = 0;
+			for (int u = 0; u < n; u++) {
+				if (mate_l[u] != -1 || layer_l[u] != 0) continue;
+				if (_Augment(u, 0, last)) augmented++;
+			}
+			return augmented;
+		}
+
+		bool _Augment(int u, int k, int last) {
+			while (true) {
+				int v = _Take(u, k);
+				if (v == -1) return false;
+				if (mate_r[v] == -1) {
+					if (k != last) continue;
+				}
+				else {
+					if (k == last || !_Augment(mate_r[v], k + 1, last)) continue;
+				}
+				mate_l[u] = v;
+				mate_r[v] = u;
+				return true;
+			}
+		}
+	};
+
+	inline double _Power(double d, float p) {
+		if (p == 1) return d;
+		if (p == 2) return d * d;
+		return pow(d, (double)p);
+	}
+
+	/**
+		DiagramKdTree with a price on every point, for the auction: the
+		queries minimize the p-th power of the L-infinity distance plus the
+		price. Every node keeps the smallest price of its range, so a range
+		is skipped when its box distance plus that price cannot beat the
+		second best, and a price change only updates one root path.
+	*/
+	class DiagramPriceKdTree : public DiagramKdTree {
+	public:
+		Array<double> price;
+		Array<double> min_price;	/// smallest price in the range of the node
+
+		void Init(const Array<float>& px, const Array<float>& py) {
+			DiagramKdTree::Init(px, py);
+			price.assign(px.size(), 0.0);
+			min_price.assign(px.size(), 0.0);
+		}
+
+		void SetPrice(int id, double value) {
+			price[id] = value;
+			_UpdatePrice(0, perm.size(), position[id]);
+		}
+
+		/**
+			the two points with the smallest distance^p + price from (qx, qy),
+			-1 and infinity when there are fewer
+		*/
+		void BestTwo(float qx, float qy, float p, int& best, double& best_value, int& second, double& second_value) const {
+			best = second = -1;
+			best_value = second_value = std::numeric_limits<double>::infinity();
+			_BestTwo(0, perm.size(), 0, qx, qy, p, best, best_value, second, second_value);
+		}
+
+	protected:
+		/// recompute min_price on the path down to target, the children of a node are the middles of its halves
+		void _UpdatePrice(int lo, int hi, int target) {
+			int mid = (lo + hi) / 2;
+			if (target < mid) _UpdatePrice(lo, mid, target);
+			else if (target > mid) _UpdatePrice(mid + 1, hi, target);
+			double m = price[perm[mid]];
+			if (lo < mid) m = myMin(m, min_price[(lo + mid) / 2]);
+			if (mid + 1 < hi) m = myMin(m, min_price[(mid + 1 + hi) / 2]);
+			min_price[mid] = m;
+		}
+
+		void _BestTwo(int lo, int hi, int axis, float qx, float qy, float p,
+			int& best, double& best_value, int& second, double& second_value) const {
+			if (lo >= hi) return;
+			int mid = (lo + hi) / 2;
+			const float* b = &box[4 * mid];
+			double dx = myMax(myMax((double)b[0] - qx, (double)qx - b[1]), 0.0);
+			double dy = myMax(myMax((double)b[2] - qy, (double)qy - b[3]), 0.0);
+			if (_Power(myMax(dx, dy), p) + min_price[mid] >= second_value) return;
+			int id = perm[mid];
+			double value = _Power(myMax(fabs((double)x[id] - qx), fabs((double)y[id] - qy)), p) + price[id];
+			if (value < best_value) {
+				second = best;
+				second_value = best_value;
+				best = id;
+				best_value = value;
+			}
+			else if (value < second_value) {
+				second = id;
+				second_value = value;
+			}
+			/// the side of the query first
+			bool low_first = (axis == 0 ? qx <= x[id] : qy <= y[id]);
+			if (low_first) {
+				_BestTwo(lo, mid, 1 - axis, qx, qy, p, best, best_value, second, second_value);
+				_BestTwo(mid + 1, hi, 1 - axis, qx, qy, p, best, best_value, second, second_value);
+			}
+			else {
+				_BestTwo(mid + 1, hi, 1 - axis, qx, qy, p, best, best_value, second, second_value);
+				_BestTwo(lo, mid, 1 - axis, qx, qy, p, best, best_value, second, second_value);
+			}
+		}
+	};
+
+	/**
+		Distance between the essential parts, the sorted births are matched
+		in order. Infinite if the counts differ, p <= 0 means bottleneck.
+	*/
+	inline double _EssentialCost(const Array<float>& a, const Array<float>& b, float p) {
+		if (a.size() != b.size()) return std::numeric_limits<double>::infinity();
+		double cost = 0;
+		for (int i = 0; i < a.size(); i++) {
+			double d = fabs((double)a[i] - b[i]);
+			if (p <= 0) cost = myMax(cost, d);
+			else cost += _Power(d, p);
+		}
+		return cost;
+	}
+
+	/**
+		Order preserving map of the nonnegative floats to the integers
+	*/
+	inline unsigned int _FloatBits(float value) {
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(float));
+		return bits;
+	}
+
+	inline float _BitsFloat(unsigned int bits) {
+		float value;
+		memcpy(&value, &bits, sizeof(float));
+		return value;
+	}
+
+	/**
+		Bottleneck distance. Whether a perfect matching exists only changes
+		at a distance the matching computes, so the distance is the smallest
+		float threshold with a perfect matching, which a binary search over
+		the float bits finds in at most 32 matchings, without listing the
+		pairwise distances.
+	*/
+	inline float BottleneckDistance(const Array<std::pair<float, float>>& diagram_a, const Array<std::pair<float, float>>& diagram_b) {
+		Array<std::pair<float, float>> a, b;
+		Array<float> essential_a, essential_b;
+		_SplitDiagram(diagram_a, a, essential_a);
+		_SplitDiagram(diagram_b, b, essential_b);
+		double essential = _EssentialCost(essential_a, essential_b, 0);
+		if (essential == std::numeric_limits<double>::infinity()) return std::numeric_limits<float>::infinity();
+		if (a.empty() && b.empty()) return (float)essential;
+
+		/// matching every point to the diagonal is always possible, the answer is at most the largest of those
+		float upper = 0;
+		for (int i = 0; i < a.size(); i++) upper = myMax(upper, _DiagonalDistance(a[i]));
+		for (int j = 0; j < b.size(); j++) upper = myMax(upper, _DiagonalDistance(b[j]));
+		DiagramMatching matching;
+		matching.Init(a, b);
+		unsigned int lo = 0;
+		unsigned int hi = _FloatBits(upper);
+		while (lo < hi) {
+			unsigned int mid = lo + (hi - lo) / 2;
+			if (matching.Perfect(_BitsFloat(mid))) hi = mid;
+			else lo = mid + 1;
+		}
+		return (float)myMax((double)_BitsFloat(lo), essential);
+	}
+
+	/**
+		p-Wasserstein distance by the auction algorithm of Bertsekas with
+		epsilon-scaling. The bidders are the points of a and the projections
+		of b, the objects the points of b and the projections of a; a point
+		costs its distance to the diagonal with any projection, two
+		projections cost 0. The scaling stops once the assignment is within
+		relative error delta of the optimum.
+
+		A bid needs the best and second best objects (Kerber, Morozov and
+		Nigmetov). For a point of a, the points of b come from a
+		DiagramPriceKdTree. For a projection of b, every point of b costs its
+		own diagonal distance, so they come from a set ordered by that cost
+		plus the price. The projections of a are alike, so the two cheapest
+		are the candidates. A bid is then logarithmic in the diagram sizes
+		instead of linear.
+	*/
+	inline float WassersteinDistance(const Array<std::pair<float, float>>& diagram_a, const Array<std::pair<float, float>>& diagram_b,
+		float p = 1, float delta = 0.01f) {
+		if (p < 1) throw "the order of the Wasserstein distance should be at least 1";
+		Array<std::pair<float, float>> a, b;
+		Array<float> essential_a, essential_b;
+		_SplitDiagram(diagram_a, a, essential_a);
+		_SplitDiagram(diagram_b, b, essential_b);
+		double essential = _EssentialCost(essential_a, essential_b, p);
+		if (essential == std::numeric_limits<double>::infinity()) return std::numeric_limits<float>::infinity();
+		int na = a.size(), nb = b.size(), n = na + nb;
+		if (n == 0) return (float)pow(essential, 1.0 / p);
+
+		Array<double> diagonal_a(na), diagonal_b(nb);
+		for (int i = 0; i < na; i++) diagonal_a[i] = _Power(0.5 * ((double)a[i].second - a[i].first), p);
+		for (int j = 0; j < nb; j++) diagonal_b[j] = _Power(0.5 * ((double)b[j].second - b[j].first), p);
+		auto cost = [&](int i, int j) -> double {
+			if (i < na) {
+				if (j < nb) return _Power(myMax(fabs((double)a[i].first - b[j].first), fabs((double)a[i].second - b[j].second)), p);
+				return diagonal_a[i];
+			}
+			return j < nb ? diagonal_b[j] : 0.0;
+		};
+		double max_cost = 0;
+		for (int i = 0; i < na; i++) max_cost = myMax(max_cost, diagonal_a[i]);
+		for (int j = 0; j < nb; j++) max_cost = myMax(max_cost, diagonal_b[j]);
+		if (max_cost == 0) return (float)pow(essential, 1.0 / p);
+
+		Array<double> price(n, 0.0);
+		Array<int> owner(n), assigned(n);
+		/// the projections of a are alike to every bidder, only the two cheapest are candidates
+		std::set<std::pair<double, int>> diagonal_price;
+		for (int j = nb; j < n; j++) diagonal_price.insert(std::make_pair(0.0, j));
+		/// the points of b for the points of a, and by diagonal cost plus price for the projections of b
+		DiagramPriceKdTree tree;
+		Array<float> bx(nb), by(nb);
+		for (int j = 0; j < nb; j++) {
+			bx[j] = b[j].first;
+			by[j] = b[j].second;
+		}
+		tree.Init(bx, by);
+		std::set<std::pair<double, int>> point_price;
+		for (int j = 0; j < nb; j++) point_price.insert(std::make_pair(diagonal_b[j], j));
+		double epsilon = max_cost / 4, total = 0;
+		while (true) {
+			owner.assign(n, -1);
+			assigned.assign(n, -1);
+			Array<int> unassigned(n);
+			for (int i = 0; i < n; i++) unassigned[i] = n - 1 - i;
+			while (!unassigned.empty()) {
+				int i = unassigned.back();
+				unassigned.pop_back();
+				int best = -1;
+				double best_value = -std::numeric_limits<double>::infinity(), second_value = -std::numeric_limits<double>::infinity();
+				auto bid = [&](int j, double value) {
+					if (j == -1) return;
+					if (value > best_value) {
+						second_value = best_value;
+						best_value = value;
+						best = j;
+					}
+					else if (value > second_value) second_value = value;
+				};
+				if (i < na) {
+					int near_best, near_second;
+					double near_best_value, near_second_value;
+					tree.BestTwo(a[i].first, a[i].second, p, near_best, near_best_value, near_second, near_second_value);
+					bid(near_best, -near_best_value);
+					bid(near_second, -near_second_value);
+				}
+				else {
+					auto it = point_price.begin();
+					for (int k = 0; k < 2 && it != point_price.end(); k++, it++) bid(it->second, -it->first);
+				}
+				auto it = diagonal_price.begin();
+				for (int k = 0; k < 2 && it != diagonal_price.end(); k++, it++) bid(it->second, -cost(i, it->second) - it->first);
+				if (second_value == -std::numeric_limits<double>::infinity()) second_value = best_value;
+				if (best >= nb) diagonal_price.erase(std::make_pair(price[best], best));
+				else point_price.erase(std::make_pair(diagonal_b[best] + price[best], best));
+				price[best] += best_value - second_value + epsilon;
+				if (best >= nb) diagonal_price.insert(std::make_pair(price[best], best));
+				else {
+					point_price.insert(std::make_pair(diagonal_b[best] + price[best], best));
+					tree.SetPrice(best, price[best]);
+				}
+				if (owner[best] != -1) {
+					assigned[owner[best]] = -1;
+					unassigned.push_back(owner[best]);
+				}
+				owner[best] = i;
+				assigned[i] = best;
+			}
+			total = 0;
+			for (int i = 0; i < n; i++) total += cost(i, assigned[i]);
+			/// the assignment is within n * epsilon of the optimum
+			if (n * epsilon <= delta * total || epsilon < max_cost * 1e-12) break;
+			epsilon /= 5;
+		}
+		return (float)pow(total + essential, 1.0 / p);
+	}
+
+	/**
+		Distance between two diagrams, p is the order of the Wasserstein distance
+	*/
+	inline float PersistenceDiagramDistance(const Array<std::pair<float, float>>& a, const Array<std::pair<float, float>>& b,
+		DiagramDistanceType type = BOTTLENECK, float p = 1, float delta = 0.01f) {
+		if (type == BOTTLENECK) return BottleneckDistance(a, b);
+		return WassersteinDistance(a, b, p, delta);
+	}
+
+	/**
+		All-pairs distances of a batch of diagrams, parallel over the pairs.
+		distance is the n x n symmetric matrix in row major.
+	*/
+	inline void PersistenceDiagramDistances(const Array<Array<std::pair<float, float>>>& diagrams, Array<float>& distance,
+		DiagramDistanceType type = BOTTLENECK, float p = 1, float delta = 0.01f) {
+		int n = diagrams.size();
+		distance.assign((size_t)n * n, 0.0f);
+		long long pair_num = (long long)n * (n - 1) / 2;
+#pragma omp parallel for schedule(dynamic)
+		for (long long k = 0; k < pair_num; k++) {
+			/// k -> (i, j) with i < j, row i holds n - 1 - i pairs
+			int i = (int)((2 * n - 1 - sqrt((double)(2 * n - 1) * (2 * n - 1) - 8.0 * k)) / 2);
+			while (i > 0 && (long long)i * (2 * n - i - 1) / 2 > k) i--;
+			while ((long long)(i + 1) * (2 * n - i - 2) / 2 <= k) i++;
+			int j = (int)(k - (long long)i * (2 * n - i - 1) / 2) + i + 1;
+			float d = PersistenceDiagramDistance(diagrams[i], diagrams[j], type, p, delta);
+			distance[(size_t)i * n + j] = d;
+			distance[(size_t)j * n + i] = d;
+		}
+	}
+
+	/**
+		The intervals of one homology dimension, feature is the feture_type
+		value of math_homology.h (the vertex number of the birth simplex)
+	*/
+	inline void DiagramOfFeature(const Array<std::pair<float, float>>& epsilon_interval, const Array<int>& feture_type,
+		int feature, Array<std::pair<float, float>>& diagram) {
+		diagram.clear();
+		for (int i = 0; i < epsilon_interval.size(); i++) {
+			if (feture_type[i] == feature) diagram.push_back(epsilon_interval[i]);
+		}
+	}
+
+	/**
+		Betti curve on a sorted grid, such as epsilon_list: out[s] counts the
+		intervals with birth <= grid[s] < death. Each interval adds +1 and -1
+		to a difference array, a prefix sum gives the curve.
+	*/
+	inline void BettiCurve(const Array<std::pair<float, float>>& diagram, const Array<float>& grid, float* out) {
+		int g = grid.size();
+		for (int s = 0; s < g; s++) out[s] = 0;
+		for (int i = 0; i < diagram.size(); i++) {
+			if (!(diagram[i].second > diagram[i].first)) continue;
+			int begin = std::lower_bound(grid.begin(), grid.end(), diagram[i].first) - grid.begin();
+			int end = std::lower_bound(grid.begin(), grid.end(), diagram[i].second) - grid.begin();
+			if (begin < g) out[begin] += 1;
+			if (end < g) out[end] -= 1;
+		}
+		for (int s = 1; s < g; s++) out[s] += out[s - 1];
+	}
+
+	/**
+		Persistence landscape (Bubenik) on a sorted grid: out[k * grid.size() + s]
+		is the (k+1)-th largest tent min(t - birth, death - t) at t = grid[s],
+		for k < level_num. An interval only visits the grid points it covers,
+		and keeps each column of out sorted by insertion.
+	*/
+	inline void PersistenceLandscape(const Array<std::pair<float, float>>& diagram, const Array<float>& grid, int level_num, float* out) {
+		int g = grid.size();
+		if (level_num <= 0) return;
+		for (int s = 0; s < level_num * g; s++) out[s] = 0;
+		for (int i = 0; i < diagram.size(); i++) {
+			float birth = diagram[i].first, death = diagram[i].second;
+			if (!(death > birth)) continue;
+			int begin = std::upper_bound(grid.begin(), grid.end(), birth) - grid.begin();
+			int end = std::lower_bound(grid.begin(), grid.end(), death) - grid.begin();
+			for (int s = begin; s < end; s++) {
+				float tent = myMin(grid[s] - birth, death - grid[s]);
+				if (tent <= out[(level_num - 1) * g + s]) continue;
+				int k = level_num - 1;
+				for (; k > 0 && out[(k - 1) * g + s] < tent; k--) out[k * g + s] = out[(k - 1) * g + s];
+				out[k * g + s] = tent;
+			}
+		}
+	}
+
+	inline void _CheckImageParameters(float birth_min, float birth_max, float persistence_max,
+		int resolution_x, int resolution_y, float sigma) {
+		if (!(sigma > 0)) throw "the deviation of the persistence image should be positive";
+		if (!(persistence_max > 0)) throw "the persistence range of the persistence image should be positive";
+		if (!(birth_max > birth_min)) throw "the birth range of the persistence image should be positive";
+		if (resolution_x <= 0 || resolution_y <= 0) throw "the resolution of the persistence image should be positive";
+	}
+
+	/// pixel coordinate clamped to [0, resolution] before the int cast, 0 for NaN
+	inline float _PixelClamp(float x, int resolution) {
+		return x > 0 ? (x < resolution ? x : (float)resolution) : 0.0f;
+	}
+
+	/**
+		Persistence image (Adams et al.) on [birth_min, birth_max] x [0, persistence_max]
+		in birth-persistence coordinates, resolution_x x resolution_y pixels,
+		out[iy * resolution_x + ix]. Every point is a Gaussian of deviation sigma
+		weighted by persistence / persistence_max, integrated exactly over the
+		pixels: the Gaussian is separable, so the pixel masses are products of
+		erf differences along each axis, only within 4 sigma of the point.
+		Essential points are skipped.
+	*/
+	inline void PersistenceImage(const Array<std::pair<float, float>>& diagram, float birth_min, float birth_max, float persistence_max,
+		int resolution_x, int resolution_y, float sigma, float* out) {
+		_CheckImageParameters(birth_min, birth_max, persistence_max, resolution_x, resolution_y, sigma);
+		for (int s = 0; s < resolution_x * resolution_y; s++) out[s] = 0;
+		float pixel_x = (birth_max - birth_min) / resolution_x, pixel_y = persistence_max / resolution_y;
+		float scale = 1.0f / (sqrt(2.0f) * sigma);
+		Array<float> mass_x(resolution_x), mass_y(resolution_y);
+		for (int i = 0; i < diagram.size(); i++) {
+			float birth = diagram[i].first, persistence = diagram[i].second - birth;
+			if (!(persistence > 0) || persistence == std::numeric_limits<float>::infinity()) continue;
+			float weight = myMin(persistence / persistence_max, 1.0f);
+			int x_begin = (int)floor(_PixelClamp((birth - 4 * sigma - birth_min) / pixel_x, resolution_x));
+			int x_end = (int)ceil(_PixelClamp((birth + 4 * sigma - birth_min) / pixel_x, resolution_x));
+			int y_begin = (int)floor(_PixelClamp((persistence - 4 * sigma) / pixel_y, resolution_y));
+			int y_end = (int)ceil(_PixelClamp((persistence + 4 * sigma) / pixel_y, resolution_y));
+			if (x_begin >= x_end || y_begin >= y_end) continue;
+			for (int ix = x_begin; ix < x_end; ix++) {
+				float left = birth_min + ix * pixel_x - birth;
+				mass_x[ix] = 0.5f * (erf((left + pixel_x) * scale) - erf(left * scale));
+			}
+			for (int iy = y_begin; iy < y_end; iy++) {
+				float bottom = iy * pixel_y - persistence;
+				mass_y[iy] = weight * 0.5f * (erf((bottom + pixel_y) * scale) - erf(bottom * scale));
+			}
+			for (int iy = y_begin; iy < y_end; iy++) {
+				float* row = out + iy * resolution_x;
+				float my = mass_y[iy];
+				for (int ix = x_begin; ix < x_end; ix++) row[ix] += my * mass_x[ix];
+			}
+		}
+	}
+
+	/**
+		Batched Betti curves, out is diagrams.size() x grid.size() in row major
+	*/
+	inline void BettiCurves(const Array<Array<std::pair<float, float>>>& diagrams, const Array<float>& grid, Array<float>& out) {
+		int n = diagrams.size(), g = grid.size();
+		out.resize((size_t)n * g);
+#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < n; i++) {
+			BettiCurve(diagrams[i], grid, &out[(size_t)i * g]);
+		}
+	}
+
+	/**
+		Batched landscapes, out is diagrams.size() x level_num x grid.size() in row major
+	*/
+	inline void PersistenceLandscapes(const Array<Array<std::pair<float, float>>>& diagrams, const Array<float>& grid, int level_num, Array<float>& out) {
+		int n = diagrams.size(), g = grid.size();
+		out.resize((size_t)n * level_num * g);
+#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < n; i++) {
+			PersistenceLandscape(diagrams[i], grid, level_num, &out[(size_t)i * level_num * g]);
+		}
+	}
+
+	/**
+		Batched persistence images, out is diagrams.size() x resolution_y x resolution_x in row major
+	*/
+	inline void PersistenceImages(const Array<Array<std::pair<float, float>>>& diagrams, float birth_min, float birth_max, float persistence_max,
+		int resolution_x, int resolution_y, float sigma, Array<float>& out) {
+		_CheckImageParameters(birth_min, birth_max, persistence_max, resolution_x, resolution_y, sigma);
+		int n = diagrams.size(), pixel_num = resolution_x * resolution_y;
+		out.resize((size_t)n * pixel_num);
+#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < n; i++) {
+			PersistenceImage(diagrams[i], birth_min, birth_max, persistence_max, resolution_x, resolution_y, sigma, &out[(size_t)i * pixel_num]);
+		}
+	}
+}
+#endif